@@ -0,0 +1,181 @@
+//=======================================================================================
+// Name        : Benchmark.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <atomic>
+
+#include "BoundedQueue.h"
+#include "RingBuffer.h"
+
+using namespace std;
+
+// items handed from producers to consumers in each run (one per small block)
+static const unsigned long long numItems = 2000000;
+static const size_t queueCapacity = 1024;
+
+/*Passes numItems block numbers from the producers to the consumers and returns the
+  hand-offs per second. The lock-free rings never wait, so their users yield while full
+  or empty; the mutex queue blocks instead.
+  */
+template<class Push, class Pop, class Close>
+static double measure(unsigned int numProducers, unsigned int numConsumers,
+		Push push, Pop pop, Close close) {
+
+	auto start = chrono::steady_clock::now();
+	vector<thread> producers, consumers;
+	vector<unsigned long long> sums(numConsumers, 0);
+
+	for (unsigned int p = 0; p < numProducers; p++) {
+
+		producers.push_back(thread([&, p]() {
+
+			for (unsigned long long i = p; i < numItems; i += numProducers) {
+
+				push(i);
+
+			}
+
+		}));
+
+	}
+
+	for (unsigned int c = 0; c < numConsumers; c++) {
+
+		consumers.push_back(thread([&, c]() {
+
+			unsigned long long item;
+
+			while (pop(item)) {
+
+				sums[c] += item;
+
+			}
+
+		}));
+
+	}
+
+	for (auto & producer : producers) {
+
+		producer.join();
+
+	}
+
+	close();
+
+	for (auto & consumer : consumers) {
+
+		consumer.join();
+
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start)
+			.count();
+
+	unsigned long long total = 0;
+
+	for (auto sum : sums) {
+
+		total += sum;
+
+	}
+
+	// every item arrives exactly once
+	if (total != numItems * (numItems - 1) / 2) {
+
+		cout << "Items lost or repeated" << endl;
+
+	}
+
+	return numItems / seconds;
+
+}
+
+static void report(string name, double rate) {
+
+	cout << left << setw(40) << name << right << setw(10) << fixed
+			<< setprecision(2) << rate / 1e6 << " M items/s" << endl;
+
+}
+
+// a mutex queue with blocking push and pop
+static double measureMutexQueue(unsigned int numProducers,
+		unsigned int numConsumers) {
+
+	DPLKYL002::BoundedQueue<unsigned long long> queue(queueCapacity);
+
+	return measure(numProducers, numConsumers,
+			[&](unsigned long long item) {queue.push(item);},
+			[&](unsigned long long & item) {return queue.pop(item);},
+			[&]() {queue.close();});
+
+}
+
+// a lock-free ring; consumers stop once the producers are done and the ring is empty
+template<class Ring>
+static double measureRing(unsigned int numProducers, unsigned int numConsumers) {
+
+	Ring ring(queueCapacity);
+	atomic<bool> done(false);
+
+	return measure(numProducers, numConsumers, [&](unsigned long long item) {
+
+		while (!ring.tryPush(item)) {
+
+			this_thread::yield();
+
+		}
+
+	}, [&](unsigned long long & item) {
+
+		while (!ring.tryPop(item)) {
+
+			// every push happened before done was set
+			if (done.load(memory_order_acquire)) {
+
+				return ring.tryPop(item);
+
+			}
+
+			this_thread::yield();
+
+		}
+
+		return true;
+
+	}, [&]() {done.store(true, memory_order_release);});
+
+}
+
+int main() {
+
+	unsigned int workers = max(2u, thread::hardware_concurrency());
+
+	cout << "Block hand-offs between pipeline stages (" << numItems << " items, capacity "
+			<< queueCapacity << ")" << endl;
+
+	report("reader -> dispatcher, mutex queue", measureMutexQueue(1, 1));
+	report("reader -> dispatcher, SPSC ring",
+			measureRing<DPLKYL002::SpscRing<unsigned long long>>(1, 1));
+
+	report("worker pool (" + to_string(workers) + " x " + to_string(workers)
+			+ "), mutex queue", measureMutexQueue(workers, workers));
+	report("worker pool (" + to_string(workers) + " x " + to_string(workers)
+			+ "), MPMC ring",
+			measureRing<DPLKYL002::MpmcRing<unsigned long long>>(workers,
+					workers));
+
+	return 0;
+
+}
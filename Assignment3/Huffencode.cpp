@@ -8,12 +8,310 @@
 //=======================================================================================
 
 #include <string>
+#include <vector>
 #include <iostream>
+#include <cstdlib>
+#include <algorithm>
 
 #include "HuffmanTree.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
+namespace {
+
+// command line settings that are not library options
+class Settings {
+public:
+
+	bool english; // the built-in English model (no header at all)
+	bool gzip; // gzip output
+	bool legacy; // the .hdr / .bin files
+	unsigned int jobs; // files compressed at once in batch mode
+	bool range; // decompress only letters [offset, offset + length)
+	unsigned long long offset, length;
+
+	Settings() :
+			english(false), gzip(false), legacy(false), jobs(0), range(false), offset(
+					0), length(~0ull) {
+
+	}
+};
+
+void printUsage(void) {
+
+	cout << "Usage:" << endl;
+	cout << "  Huffencode compress <input> <output> [options]" << endl;
+	cout << "  Huffencode decompress <input> <output> [options]" << endl;
+	cout << "  Huffencode verify <input> <compressed file> [options]" << endl;
+	cout << "  Huffencode batch <output directory> <files / directories...> [-j <jobs>] [options]" << endl;
+	cout << "  Huffencode archive <archive> <files / directories...> [-j <jobs>] [options]" << endl;
+	cout << "  Huffencode list <archive>" << endl;
+	cout << "  Huffencode extract <archive> <output directory> [members...] [options]" << endl;
+	cout << "  Huffencode train <table directory> <corpus files...>" << endl;
+	cout << "  Huffencode huffencode <input> <output> [--english | --table <id> --tables <directory>]" << endl;
+	cout << "Options:" << endl;
+	cout << "  --block-size <bytes>  bytes per block (k / m suffixes allowed), default 1m" << endl;
+	cout << "  --threads <n>         threads per file, default one per core" << endl;
+	cout << "  --level <0-9>         LZ77 match finder effort, default 6" << endl;
+	cout << "  --mode <mode>         bytes, words, rle, bwt or lz77, default bytes" << endl;
+	cout << "  --split               split blocks where the letter statistics change" << endl;
+	cout << "  --backend <backend>   streams, pread or uring, default streams" << endl;
+	cout << "  --direct              bypass the page cache (O_DIRECT)" << endl;
+	cout << "  --huge-pages          huge pages for the O_DIRECT buffers" << endl;
+	cout << "  --table <id>          code with a trained table" << endl;
+	cout << "  --tables <directory>  where trained tables are kept, default ." << endl;
+	cout << "  --english             the built-in English model" << endl;
+	cout << "  --gzip                gzip output" << endl;
+	cout << "  --legacy              the .hdr / .bin files" << endl;
+	cout << "  --sync-interval <n>   with --legacy, a sync point every n letters (k / m suffixes allowed)" << endl;
+	cout << "  --offset <n>          decompress from letter n (fast for legacy files with sync points)" << endl;
+	cout << "  --length <n>          decompress at most n letters" << endl;
+
+}
+
+// a count, optionally followed by k or m (kibibytes, mebibytes)
+bool parseNumber(string text, unsigned long long & value) {
+
+	char * end;
+
+	value = strtoull(text.c_str(), &end, 10);
+
+	if (end == text.c_str()) {
+
+		return false;
+
+	}
+
+	string suffix(end);
+
+	if (suffix == "k" || suffix == "K") {
+
+		value <<= 10;
+
+	} else if (suffix == "m" || suffix == "M") {
+
+		value <<= 20;
+
+	} else if (suffix != "") {
+
+		return false;
+
+	}
+
+	return true;
+
+}
+
+/*Reads the flags in argv[first, argc) into options and settings; everything else is an
+  argument. Returns false (after saying why) for a flag it does not know.
+  */
+bool parseFlags(int argc, char * argv[], int first,
+		DPLKYL002::HuffmanTree::Options & options, Settings & settings,
+		vector<string> & arguments) {
+
+	for (int i = first; i < argc; i++) {
+
+		string flag = string(argv[i]);
+		string value = i + 1 < argc ? string(argv[i + 1]) : "";
+		unsigned long long number = 0;
+		bool valid = true;
+
+		if (flag.size() < 2 || flag[0] != '-') {
+
+			arguments.push_back(flag);
+			continue;
+
+		}
+
+		bool takesValue = flag == "--block-size" || flag == "--threads"
+				|| flag == "-j" || flag == "--jobs" || flag == "--level"
+				|| flag == "--mode" || flag == "--backend" || flag == "--table"
+				|| flag == "--tables" || flag == "--sync-interval"
+				|| flag == "--offset" || flag == "--length";
+
+		if (flag == "--english") {
+
+			settings.english = true;
+
+		} else if (flag == "--gzip") {
+
+			settings.gzip = true;
+
+		} else if (flag == "--legacy") {
+
+			settings.legacy = true;
+
+		} else if (flag == "--split") {
+
+			options.splitBlocks = true;
+
+		} else if (flag == "--direct") {
+
+			options.directIO = true;
+
+		} else if (flag == "--huge-pages") {
+
+			options.hugePages = true;
+
+		} else if (!takesValue) {
+
+			cout << "Unknown option: " << flag << endl;
+			return false;
+
+		} else if (i + 1 >= argc) {
+
+			valid = false;
+
+		} else if (flag == "--block-size") {
+
+			valid = parseNumber(argv[++i], number) && number > 0
+					&& number <= 0xFFFFFFFFull;
+			options.blockSize = number;
+
+		} else if (flag == "--threads") {
+
+			valid = parseNumber(argv[++i], number) && number > 0;
+			options.threads = number;
+
+		} else if (flag == "-j" || flag == "--jobs") {
+
+			valid = parseNumber(argv[++i], number) && number > 0;
+			settings.jobs = number;
+
+		} else if (flag == "--level") {
+
+			valid = parseNumber(argv[++i], number) && number <= 9;
+			options.level = number;
+
+		} else if (flag == "--mode") {
+
+			i++;
+
+			if (value == "bytes") {
+
+				options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_BYTES;
+
+			} else if (value == "words") {
+
+				options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_WORDS;
+
+			} else if (value == "rle") {
+
+				options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_RLE;
+
+			} else if (value == "bwt") {
+
+				options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_BWT;
+
+			} else if (value == "lz77") {
+
+				options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_LZ77;
+
+			} else {
+
+				valid = false;
+
+			}
+
+		} else if (flag == "--backend") {
+
+			i++;
+
+			if (value == "streams") {
+
+				options.backend = DPLKYL002::FileIO::BACKEND_STREAMS;
+
+			} else if (value == "pread") {
+
+				options.backend = DPLKYL002::FileIO::BACKEND_PREAD;
+
+			} else if (value == "uring") {
+
+				options.backend = DPLKYL002::FileIO::BACKEND_URING;
+
+			} else {
+
+				valid = false;
+
+			}
+
+		} else if (flag == "--table") {
+
+			char * end;
+
+			options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_TRAINED;
+			options.tableId = strtoul(argv[++i], &end, 16);
+			valid = *end == '\0' && options.tableId != 0;
+
+		} else if (flag == "--tables") {
+
+			options.tableDirectory = string(argv[++i]);
+
+		} else if (flag == "--sync-interval") {
+
+			valid = parseNumber(argv[++i], number) && number > 0
+					&& number <= 0xFFFFFFFFull;
+			options.syncInterval = number;
+
+		} else if (flag == "--offset") {
+
+			valid = parseNumber(argv[++i], settings.offset);
+			settings.range = true;
+
+		} else if (flag == "--length") {
+
+			valid = parseNumber(argv[++i], settings.length);
+			settings.range = true;
+
+		}
+
+		if (!valid) {
+
+			cout << "Invalid value for " << flag << ": " << value << endl;
+			return false;
+
+		}
+
+	}
+
+	return true;
+
+}
+
+// the decompressed bytes of a file of any format
+bool decompressToBuffer(DPLKYL002::HuffmanTree & tree, string inputFileName,
+		DPLKYL002::HuffmanTree::bufferType & output,
+		const DPLKYL002::HuffmanTree::Options & options,
+		const Settings & settings) {
+
+	if (!settings.english) {
+
+		return tree.decompressFile(inputFileName, output, options);
+
+	}
+
+	DPLKYL002::HuffmanTree::bufferType input;
+
+	if (!tree.readFile(inputFileName, input, options)) {
+
+		return false;
+
+	}
+
+	if (!tree.decodeEnglish(input.data(), input.size(), output)) {
+
+		cout << "Corrupt compressed file: " << inputFileName << endl;
+		return false;
+
+	}
+
+	return true;
+
+}
+
+}
+
 // main function
 int main(int argc, char * argv[]) { // argc and argv values passed into main
 
@@ -21,6 +319,249 @@ int main(int argc, char * argv[]) { // argc and argv values passed into main
 	// argv array - contains simple C-strings for each of these items
 	// argv[0] is always the application name, and argv[1] the first argument
 
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+	Settings settings;
+	vector<string> arguments;
+	string command = argc >= 2 ? string(argv[1]) : "";
+
+	if (command == "help" || command == "--help" || command == "-h") {
+
+		printUsage();
+		return 0;
+
+	}
+
+	// train mode: Huffencode train <table directory> <corpus files...>
+	if (argc >= 4 && command == "train") {
+
+		vector<string> corpusFileNames(argv + 3, argv + argc);
+		unsigned int tableId = tree.trainTable(corpusFileNames, argv[2]);
+
+		if (tableId == 0) {
+
+			cout << "Unable to train a table" << endl;
+			return 1;
+
+		}
+
+		cout << "Table ID: " << hex << tableId << dec << endl;
+
+		return 0;
+
+	}
+
+	// batch mode: Huffencode batch <output directory> <files / directories...> [-j <jobs>]
+	if (argc >= 4 && command == "batch") {
+
+		if (!parseFlags(argc, argv, 3, options, settings, arguments)) {
+
+			return 1;
+
+		}
+
+		unsigned int jobs = settings.jobs > 0 ? settings.jobs : options.threads;
+
+		// more jobs than cores (e.g. for slow disks) need more workers
+		if (jobs > DPLKYL002::ThreadPool::shared().size() + 1) {
+
+			DPLKYL002::ThreadPool::configure(jobs - 1);
+
+		}
+
+		options.threads = max(options.threads, jobs);
+
+		DPLKYL002::HuffmanTree::FilesReport report = tree.compressFiles(arguments,
+				argv[2], options, jobs);
+		double megabytes = report.inputBytes / 1e6;
+
+		cout << "Compressed " << report.numFiles - report.numFailed << " of "
+				<< report.numFiles << " files: " << megabytes << " MB to "
+				<< report.outputBytes / 1e6 << " MB in " << report.seconds << " s ("
+				<< (report.seconds > 0 ? megabytes / report.seconds : 0) << " MB/s)"
+				<< endl;
+
+		return report.numFailed == 0 ? 0 : 1;
+
+	}
+
+	// archive mode: one file holding many members, any of which can be extracted on its own
+	if (argc >= 4 && command == "archive") {
+
+		if (!parseFlags(argc, argv, 3, options, settings, arguments)) {
+
+			return 1;
+
+		}
+
+		unsigned int jobs = settings.jobs > 0 ? settings.jobs : options.threads;
+
+		if (jobs > DPLKYL002::ThreadPool::shared().size() + 1) {
+
+			DPLKYL002::ThreadPool::configure(jobs - 1);
+
+		}
+
+		options.threads = max(options.threads, jobs);
+
+		return tree.createArchive(arguments, argv[2], options, jobs) ? 0 : 1;
+
+	}
+
+	if (argc == 3 && command == "list") {
+
+		vector<DPLKYL002::HuffmanTree::ArchiveMember> members;
+
+		if (!tree.readArchiveDirectory(argv[2], members)) {
+
+			return 1;
+
+		}
+
+		for (const auto & member : members) {
+
+			cout << member.originalSize << "\t" << member.compressedSize << "\t"
+					<< member.name << endl;
+
+		}
+
+		return 0;
+
+	}
+
+	if (argc >= 4 && command == "extract") {
+
+		if (!parseFlags(argc, argv, 4, options, settings, arguments)) {
+
+			return 1;
+
+		}
+
+		return tree.extractArchive(argv[2], argv[3], arguments, options) ? 0 : 1;
+
+	}
+
+	// Huffencode compress <input> <output> - one compressed file and nothing else
+	if (command == "compress" || command == "decompress" || command == "verify") {
+
+		if (argc < 4) {
+
+			printUsage();
+			return 1;
+
+		}
+
+		if (!parseFlags(argc, argv, 4, options, settings, arguments)) {
+
+			return 1;
+
+		}
+
+		if (!arguments.empty()) {
+
+			cout << "Unexpected argument: " << arguments[0] << endl;
+			return 1;
+
+		}
+
+		string inputFileName = string(argv[2]);
+		string outputFileName = string(argv[3]);
+
+		if (command == "compress") {
+
+			if (settings.english) {
+
+				DPLKYL002::HuffmanTree::bufferType input, output;
+
+				if (!tree.readFile(inputFileName, input, options)) {
+
+					return 1;
+
+				}
+
+				tree.encodeEnglish(input.data(), input.size(), output);
+
+				return tree.writeFile(outputFileName, output, options) ? 0 : 1;
+
+			}
+
+			if (settings.gzip) {
+
+				return tree.compressGzip(inputFileName, outputFileName, options) ?
+						0 : 1;
+
+			}
+
+			if (settings.legacy) {
+
+				return tree.compress(inputFileName, outputFileName, options) ? 0 : 1;
+
+			}
+
+			return tree.compressContainer(inputFileName, outputFileName, options) ?
+					0 : 1;
+
+		}
+
+		// the format of the compressed file is worked out from the file itself
+		if (command == "decompress") {
+
+			DPLKYL002::HuffmanTree::bufferType output;
+
+			if (settings.range && !settings.english) {
+
+				if (!tree.decompressRange(inputFileName, settings.offset,
+						settings.length, output, options)) {
+
+					return 1;
+
+				}
+
+			} else if (!decompressToBuffer(tree, inputFileName, output, options,
+					settings)) {
+
+				return 1;
+
+			} else if (settings.range) {
+
+				output.erase(output.begin(),
+						output.begin() + min((unsigned long long) output.size(),
+								settings.offset));
+				output.resize(min((unsigned long long) output.size(),
+						settings.length));
+
+			}
+
+			return tree.writeFile(outputFileName, output, options) ? 0 : 1;
+
+		}
+
+		// verify: the compressed file must decompress to the input
+		DPLKYL002::HuffmanTree::bufferType original, decompressed;
+
+		if (!tree.readFile(inputFileName, original, options)
+				|| !decompressToBuffer(tree, outputFileName, decompressed, options,
+						settings)) {
+
+			return 1;
+
+		}
+
+		if (decompressed != original) {
+
+			cout << "Mismatch: " << outputFileName << " does not decompress to "
+					<< inputFileName << endl;
+			return 1;
+
+		}
+
+		cout << "Verified: " << outputFileName << " (" << original.size()
+				<< " bytes)" << endl;
+
+		return 0;
+
+	}
+
 	// if number of items on command line is less than 3
 	if (argc < 4) {
 
@@ -30,10 +571,49 @@ int main(int argc, char * argv[]) { // argc and argv values passed into main
 
 	}
 
+	/*The original form: Huffencode <anything> <input> <output> compresses the input and
+	  decompresses it again to decompressed_<input>, to show that decompression works.
+	  */
 	string inputFileName = string(argv[2]); // an input English (ASCII) text file
 	string outputFileName = string(argv[3]); // an output compressed "bitstream"
 
-	DPLKYL002::HuffmanTree tree;
+	// --table <id> [--tables <directory>] codes with a trained table instead of a per-file header
+	// --english codes with the built-in English model (no header at all)
+	if (!parseFlags(argc, argv, 4, options, settings, arguments)) {
+
+		return 0;
+
+	}
+
+	if (settings.english) {
+
+		DPLKYL002::HuffmanTree::bufferType input, output, decompressed;
+
+		if (!tree.readFile(inputFileName, input)) {
+
+			return 0;
+
+		}
+
+		tree.encodeEnglish(input.data(), input.size(), output);
+		tree.writeFile(outputFileName, output);
+
+		tree.decodeEnglish(output.data(), output.size(), decompressed);
+		tree.writeFile("decompressed_" + inputFileName, decompressed);
+
+		return 0;
+
+	}
+
+	if (options.frontEnd == DPLKYL002::HuffmanTree::FRONT_END_TRAINED) {
+
+		tree.compressContainer(inputFileName, outputFileName, options);
+		tree.decompressContainer(outputFileName, "decompressed_" + inputFileName,
+				options);
+
+		return 0;
+
+	}
 
 	tree.compress(inputFileName, outputFileName);
 	tree.decompress(outputFileName, "decompressed_" + inputFileName);
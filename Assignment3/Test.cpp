@@ -10,11 +10,101 @@
 #define CATCH_CONFIG_MAIN
 
 #include <fstream>
+#include <cstdlib>
+#include <cstdio>
+#include <ftw.h>
+#include <unistd.h>
 #include "catch.hpp"
 #include "HuffmanTree.h"
+#include "BlockSort.h"
+#include "EnglishModel.h"
+#include "BoundedQueue.h"
+#include "RingBuffer.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
+/*Tests which create their own files work in a fresh temporary directory, which is removed
+  (with everything in it) when the test ends, so no files are left behind.
+  */
+static int removeTestEntry(const char * path, const struct stat *, int, struct FTW *) {
+
+	return remove(path);
+
+}
+
+class TestDirectory {
+public:
+
+	TestDirectory(void) {
+
+		const char * temp = getenv("TMPDIR");
+		string pattern = string(temp && *temp ? temp : "/tmp") + "/huffencode_test_XXXXXX";
+		char * cwd = getcwd(nullptr, 0);
+
+		previous = cwd ? cwd : ".";
+		free(cwd);
+
+		vector<char> path(pattern.begin(), pattern.end());
+		path.push_back('\0');
+
+		directory = mkdtemp(path.data()) ? path.data() : "";
+
+		REQUIRE(directory != "");
+		REQUIRE(chdir(directory.c_str()) == 0);
+
+	}
+
+	~TestDirectory(void) {
+
+		if (chdir(previous.c_str()) == 0 && directory != "") {
+
+			nftw(directory.c_str(), removeTestEntry, 16, FTW_DEPTH | FTW_PHYS);
+
+		}
+
+	}
+
+private:
+
+	string previous, directory;
+
+};
+
+// helpers for tests which create their own input files
+static void writeTestFile(string fileName, string contents) {
+
+	ofstream outputFile(fileName.c_str(), ios::binary);
+	outputFile << contents;
+	outputFile.close();
+
+}
+
+static string readTestFile(string fileName) {
+
+	ifstream inputFile(fileName.c_str(), ios::binary);
+
+	return string(istreambuf_iterator<char>(inputFile),
+			istreambuf_iterator<char>());
+
+}
+
+// sample English text with plenty of repeated words
+static string sampleText(void) {
+
+	string text;
+
+	for (int i = 0; i < 200; i++) {
+
+		text += "It was the best of times, it was the worst of times, it was the age of wisdom, ";
+		text += "it was the age of foolishness (" + to_string(i) + ").\r\n";
+
+	}
+
+	return text;
+
+}
+
 // unit tests
 
 TEST_CASE("TESTING COMPRESSION:") {
@@ -29,6 +119,9 @@ TEST_CASE("TESTING COMPRESSION:") {
 
 	string inputFileName = "unit_tests/test1.txt";
 
+	// the unit_tests fixtures are not created by the tests, so stop here without them
+	REQUIRE(ifstream(inputFileName.c_str()).is_open());
+
 	SECTION("TESTING createMap:"){
 
 	tree.createMap(map, inputFileName);
@@ -116,6 +209,9 @@ TEST_CASE("TESTING DECOMPRESSION:") {
 	string inputFileName = "unit_tests/test2.txt";
 	string outputFileName = "unit_tests/output2";
 
+	// without the fixture the eof() loops below would never end
+	REQUIRE(ifstream(inputFileName.c_str()).is_open());
+
 	tree.compress(inputFileName, outputFileName);
 	tree.decompress(outputFileName, inputFileName + "_decompressed");
 
@@ -134,6 +230,8 @@ TEST_CASE("TESTING DECOMPRESSION:") {
 
 	ifstream outputFile((inputFileName + "_decompressed").c_str());
 
+	REQUIRE(outputFile.is_open());
+
 	while(!outputFile.eof()) {
 
 		outputFile >> line;
@@ -153,6 +251,9 @@ TEST_CASE("TESTING DECOMPRESSION:") {
 		string inputFileName = "unit_tests/test3.txt";
 		string outputFileName = "unit_tests/output3";
 
+		// without the fixture the eof() loops below would never end
+		REQUIRE(ifstream(inputFileName.c_str()).is_open());
+
 		tree.compress(inputFileName, outputFileName);
 		tree.decompress(outputFileName, inputFileName + "_decompressed");
 
@@ -171,6 +272,10 @@ TEST_CASE("TESTING DECOMPRESSION:") {
 
 		ifstream outputFile((inputFileName + "_decompressed").c_str());
 
+		REQUIRE(outputFile.is_open());
+
+	REQUIRE(outputFile.is_open());
+
 		while(!outputFile.eof()) {
 
 			outputFile >> line;
@@ -191,6 +296,9 @@ TEST_CASE("TESTING DECOMPRESSION:") {
 		string inputFileName = "unit_tests/test4.txt";
 		string outputFileName = "unit_tests/output4";
 
+		// without the fixture the eof() loops below would never end
+		REQUIRE(ifstream(inputFileName.c_str()).is_open());
+
 		tree.compress(inputFileName, outputFileName);
 		tree.decompress(outputFileName, inputFileName + "_decompressed");
 
@@ -209,6 +317,10 @@ TEST_CASE("TESTING DECOMPRESSION:") {
 
 		ifstream outputFile((inputFileName + "_decompressed").c_str());
 
+		REQUIRE(outputFile.is_open());
+
+	REQUIRE(outputFile.is_open());
+
 		while(!outputFile.eof()) {
 
 			outputFile >> line;
@@ -223,3 +335,2422 @@ TEST_CASE("TESTING DECOMPRESSION:") {
 	}
 
 }
+
+
+TEST_CASE("TESTING WORD MODE:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+
+	SECTION("Check word mode output decompresses to the original text:") {
+
+		string text = sampleText();
+		writeTestFile("words_input.txt", text);
+
+		tree.compressWords("words_input.txt", "words_output");
+		tree.decompressWords("words_output", "words_decompressed.txt");
+
+		REQUIRE(readTestFile("words_decompressed.txt") == text);
+		REQUIRE(readTestFile("words_output").size() < text.size() / 4);
+
+	}
+
+	SECTION("Check frequent tokens are added to the dictionary:") {
+
+		string text = "the cat and the hat, the end";
+		DPLKYL002::HuffmanTree::bufferType input(text.begin(), text.end());
+		vector<string> dictionary;
+		vector<unsigned int> symbols;
+
+		tree.createWordDictionary(input, dictionary);
+		tree.tokenizeWords(input, dictionary, symbols);
+
+		REQUIRE(find(dictionary.begin(), dictionary.end(), "the") != dictionary.end());
+		REQUIRE(find(dictionary.begin(), dictionary.end(), "cat") == dictionary.end());
+		REQUIRE(symbols[0] >= 256);
+
+	}
+
+	SECTION("Check empty and single character inputs:") {
+
+		writeTestFile("words_empty.txt", "");
+		tree.compressWords("words_empty.txt", "words_empty_output");
+		tree.decompressWords("words_empty_output", "words_empty_decompressed.txt");
+		REQUIRE(readTestFile("words_empty_decompressed.txt") == "");
+
+		writeTestFile("words_single.txt", "aaaa");
+		tree.compressWords("words_single.txt", "words_single_output");
+		tree.decompressWords("words_single_output", "words_single_decompressed.txt");
+		REQUIRE(readTestFile("words_single_decompressed.txt") == "aaaa");
+
+	}
+
+}
+
+TEST_CASE("TESTING RUN-LENGTH MODE:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+	options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_RLE;
+
+	// log-like text with long runs of padding
+	string text;
+
+	for (int i = 0; i < 100; i++) {
+
+		text += "entry " + to_string(i) + string(300, ' ') + "|" + string(200, '-') + "\n";
+
+	}
+
+	SECTION("Check run-length output decompresses to the original text:") {
+
+		writeTestFile("rle_input.txt", text);
+
+		tree.compressContainer("rle_input.txt", "rle_output", options);
+		tree.decompressContainer("rle_output", "rle_decompressed.txt");
+
+		REQUIRE(readTestFile("rle_decompressed.txt") == text);
+
+		// well under the 1 bit per byte limit of per-byte Huffman codes
+		REQUIRE(readTestFile("rle_output").size() < text.size() / 16);
+
+	}
+
+	SECTION("Check a block holding a single symbol is stored as that symbol:") {
+
+		DPLKYL002::HuffmanTree::bufferType input(100000, 'x'), output, decoded;
+
+		tree.compressBuffer(input, output, options);
+
+		REQUIRE(output.size() < 32);
+		REQUIRE(tree.decompressBuffer(output, decoded));
+		REQUIRE(decoded == input);
+
+	}
+
+	SECTION("Check long runs over a flat histogram are run-length coded:") {
+
+		// every byte value equally often, so an order-0 code would not shrink it
+		DPLKYL002::HuffmanTree::bufferType input, output, decoded;
+
+		for (int letter = 0; letter < 256; letter++) {
+
+			input.insert(input.end(), 1000, (unsigned char) letter);
+
+		}
+
+		tree.compressBuffer(input, output, options);
+
+		REQUIRE(output.size() < 2000);
+		REQUIRE(tree.decompressBuffer(output, decoded));
+		REQUIRE(decoded == input);
+
+		vector<unsigned int> frequencies(256, 1000);
+
+		REQUIRE(tree.chooseBlockType(frequencies, input.size(), options.frontEnd)
+				== DPLKYL002::HuffmanTree::BLOCK_HUFFMAN);
+
+	}
+
+	SECTION("Check small blocks decompress to the original text:") {
+
+		DPLKYL002::HuffmanTree::bufferType input(text.begin(), text.end()), output, decoded;
+
+		options.blockSize = 1000;
+		tree.compressBuffer(input, output, options);
+
+		REQUIRE(tree.decompressBuffer(output, decoded));
+		REQUIRE(decoded == input);
+
+		options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_BYTES;
+		output.clear();
+		decoded.clear();
+		tree.compressBuffer(input, output, options);
+
+		REQUIRE(tree.decompressBuffer(output, decoded));
+		REQUIRE(decoded == input);
+
+	}
+
+	SECTION("Check legacy files with a single letter get a one bit code:") {
+
+		writeTestFile("single_letter.txt", "aaaa");
+
+		tree.compress("single_letter.txt", "single_letter_output");
+		tree.decompress("single_letter_output", "single_letter_decompressed.txt");
+
+		REQUIRE(readTestFile("single_letter_output") == "4\n0000");
+		REQUIRE(readTestFile("single_letter_decompressed.txt") == "aaaa");
+
+	}
+
+}
+
+TEST_CASE("TESTING BLOCK SORTING MODE:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::BlockSort blockSort;
+
+	SECTION("Check suffix array matches a naive suffix sort:") {
+
+		string text = "mississippi banana bandana";
+		vector<unsigned int> suffixArray, expected;
+
+		for (unsigned int i = 0; i < text.size(); i++) {
+
+			expected.push_back(i);
+
+		}
+
+		sort(expected.begin(), expected.end(), [&](unsigned int a, unsigned int b) {
+
+			return text.substr(a) < text.substr(b);
+
+		});
+
+		blockSort.buildSuffixArray((const unsigned char *) text.data(), text.size(), suffixArray);
+
+		REQUIRE(suffixArray == expected);
+
+	}
+
+	SECTION("Check inverse transform restores the block:") {
+
+		string text = "abracadabra abracadabra";
+		vector<unsigned char> transformed, restored;
+
+		unsigned int primaryIndex = blockSort.transform((const unsigned char *) text.data(), text.size(), transformed);
+
+		REQUIRE(blockSort.inverseTransform(transformed.data(), transformed.size(), primaryIndex, restored));
+		REQUIRE(string(restored.begin(), restored.end()) == text);
+
+	}
+
+	SECTION("Check block sorted output decompresses to the original text:") {
+
+		string text = sampleText();
+		DPLKYL002::HuffmanTree::bufferType input(text.begin(), text.end()), output, decoded, bytesOutput;
+		DPLKYL002::HuffmanTree::Options options;
+
+		options.blockSize = 5000;
+		options.threads = 4;
+		tree.compressBuffer(input, bytesOutput, options);
+
+		options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_BWT;
+		tree.compressBuffer(input, output, options);
+
+		REQUIRE(tree.decompressBuffer(output, decoded));
+		REQUIRE(decoded == input);
+		REQUIRE(output.size() < bytesOutput.size() / 2);
+
+	}
+
+	SECTION("Check block sorting of binary data:") {
+
+		DPLKYL002::HuffmanTree::bufferType input, output, decoded;
+		DPLKYL002::HuffmanTree::Options options;
+
+		for (unsigned int i = 0; i < 50000; i++) {
+
+			input.push_back((i * 2654435761u) >> 24);
+
+		}
+
+		options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_BWT;
+		tree.compressBuffer(input, output, options);
+
+		REQUIRE(tree.decompressBuffer(output, decoded));
+		REQUIRE(decoded == input);
+
+	}
+
+}
+
+TEST_CASE("TESTING LZ77 MODE:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+
+	string text = sampleText();
+	DPLKYL002::HuffmanTree::bufferType input(text.begin(), text.end()), bytesOutput;
+
+	tree.compressBuffer(input, bytesOutput, options);
+
+	options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_LZ77;
+
+	SECTION("Check every level decompresses to the original text:") {
+
+		for (unsigned int level = 0; level <= 9; level++) {
+
+			DPLKYL002::HuffmanTree::bufferType output, decoded;
+
+			options.level = level;
+			tree.compressBuffer(input, output, options);
+
+			REQUIRE(tree.decompressBuffer(output, decoded));
+			REQUIRE(decoded == input);
+
+			if (level > 0) {
+
+				REQUIRE(output.size() < bytesOutput.size() / 4);
+
+			}
+
+		}
+
+	}
+
+	SECTION("Check matches never reach outside the window or the block:") {
+
+		DPLKYL002::LZ77 matchFinder(9);
+		vector<DPLKYL002::LZ77::Token> tokens;
+		size_t position = 0;
+
+		matchFinder.findMatches(input.data(), input.size(), tokens);
+
+		for (const auto & token : tokens) {
+
+			if (token.length > 0) {
+
+				REQUIRE(token.distance <= position);
+				REQUIRE(token.distance <= DPLKYL002::LZ77::windowSize);
+				REQUIRE(token.length <= DPLKYL002::LZ77::maxMatch);
+
+			}
+
+			position += token.length > 0 ? token.length : 1;
+
+		}
+
+		REQUIRE(position == input.size());
+
+	}
+
+}
+
+TEST_CASE("TESTING GZIP OUTPUT:") {
+
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+
+	string text = sampleText();
+	DPLKYL002::HuffmanTree::bufferType input(text.begin(), text.end());
+
+	SECTION("Check gzip framing:") {
+
+		DPLKYL002::HuffmanTree::bufferType output;
+		tree.encodeGzip(input, output, options);
+
+		REQUIRE(output[0] == 0x1F);
+		REQUIRE(output[1] == 0x8B);
+		REQUIRE(output[2] == 8); // DEFLATE
+
+		// trailer holds the CRC-32 and the input size
+		unsigned int crc = 0, size = 0;
+
+		for (int i = 0; i < 4; i++) {
+
+			crc |= output[output.size() - 8 + i] << (8 * i);
+			size |= output[output.size() - 4 + i] << (8 * i);
+
+		}
+
+		REQUIRE(crc == tree.crc32(input.data(), input.size()));
+		REQUIRE(size == input.size());
+		REQUIRE(tree.crc32((const unsigned char *) "123456789", 9) == 0xCBF43926);
+
+	}
+
+	SECTION("Check DEFLATE stream inflates to the original text:") {
+
+		for (unsigned int level : { 0, 1, 6, 9 }) {
+
+			DPLKYL002::HuffmanTree::bufferType output, decoded;
+
+			options.level = level;
+			options.blockSize = 3000;
+			tree.encodeGzip(input, output, options);
+
+			REQUIRE(tree.decodeGzip(output, decoded));
+			REQUIRE(decoded == input);
+
+		}
+
+	}
+
+	SECTION("Check empty input:") {
+
+		DPLKYL002::HuffmanTree::bufferType empty, output, decoded;
+
+		tree.encodeGzip(empty, output, options);
+
+		REQUIRE(output.size() == 20);
+		REQUIRE(tree.decodeGzip(output, decoded));
+		REQUIRE(decoded.empty());
+
+	}
+
+	SECTION("Check gzip files are read and written through every backend:") {
+
+		TestDirectory directory;
+
+		writeTestFile("gzip_input.txt", text);
+
+		for (auto backend : { DPLKYL002::FileIO::BACKEND_STREAMS,
+				DPLKYL002::FileIO::BACKEND_PREAD, DPLKYL002::FileIO::BACKEND_URING }) {
+
+			options.backend = backend;
+
+			for (bool directIO : { false, true }) {
+
+				options.directIO = directIO;
+
+				REQUIRE(tree.compressGzip("gzip_input.txt", "gzip_output", options));
+				REQUIRE(tree.decompressGzip("gzip_output", "gzip_decompressed.txt",
+						options));
+				REQUIRE(readTestFile("gzip_decompressed.txt") == text);
+
+			}
+
+		}
+
+		REQUIRE_FALSE(tree.decompressGzip("no_such_file.txt", "gzip_decompressed.txt"));
+		REQUIRE_FALSE(tree.decompressGzip("gzip_input.txt", "gzip_decompressed.txt"));
+		REQUIRE_FALSE(tree.decompressGzip("gzip_output", "no_such_directory/output.txt"));
+
+	}
+
+}
+
+TEST_CASE("TESTING ADAPTIVE BLOCK SPLITTING:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+
+	// prose, then a table of numbers, then prose again
+	string text = sampleText();
+	string table;
+
+	for (int i = 0; table.size() < 40000; i++) {
+
+		table += to_string(i * 7919 % 100000) + "\t" + to_string(i) + "\n";
+
+	}
+
+	text += table + sampleText();
+
+	DPLKYL002::HuffmanTree::bufferType input(text.begin(), text.end()), fixedOutput, splitOutput, decoded;
+
+	SECTION("Check splits are chosen where the statistics change:") {
+
+		vector<size_t> blockStarts;
+
+		options.splitBlocks = true;
+		tree.chooseBlockSplits(input.data(), input.size(), options, blockStarts);
+
+		REQUIRE(blockStarts.size() >= 4);
+		REQUIRE(blockStarts.front() == 0);
+		REQUIRE(blockStarts.back() == input.size());
+
+		// the same input as one table is not split
+		string prose = sampleText();
+		tree.chooseBlockSplits((const unsigned char *) prose.data(), prose.size(), options, blockStarts);
+
+		REQUIRE(blockStarts.size() == 2);
+
+	}
+
+	SECTION("Check split output is smaller and decompresses to the original text:") {
+
+		tree.compressBuffer(input, fixedOutput, options);
+
+		options.splitBlocks = true;
+		tree.compressBuffer(input, splitOutput, options);
+
+		REQUIRE(splitOutput.size() < fixedOutput.size());
+		REQUIRE(tree.decompressBuffer(splitOutput, decoded));
+		REQUIRE(decoded == input);
+
+	}
+
+}
+
+TEST_CASE("TESTING BLOCK TYPE SELECTION:") {
+
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+
+	// incompressible (uniformly distributed) bytes
+	DPLKYL002::HuffmanTree::bufferType random, output, decoded;
+	unsigned int seed = 12345;
+
+	for (int i = 0; i < 70000; i++) {
+
+		seed = seed * 1103515245 + 12345;
+		random.push_back(seed >> 16);
+
+	}
+
+	const size_t blockTypeOffset = 8 + 4 + 8; // container header, block size, raw and payload sizes
+
+	SECTION("Check incompressible blocks are stored raw:") {
+
+		for (auto frontEnd : { DPLKYL002::HuffmanTree::FRONT_END_BYTES, DPLKYL002::HuffmanTree::FRONT_END_RLE,
+				DPLKYL002::HuffmanTree::FRONT_END_BWT, DPLKYL002::HuffmanTree::FRONT_END_LZ77 }) {
+
+			output.clear();
+			decoded.clear();
+			options.frontEnd = frontEnd;
+			tree.compressBuffer(random, output, options);
+
+			REQUIRE(output[blockTypeOffset] == DPLKYL002::HuffmanTree::BLOCK_STORED);
+			REQUIRE(output.size() == random.size() + blockTypeOffset + 1 + 4);
+			REQUIRE(tree.decompressBuffer(output, decoded));
+			REQUIRE(decoded == random);
+
+		}
+
+	}
+
+	SECTION("Check block types are chosen from the histogram:") {
+
+		vector<unsigned int> frequencies(256, 0);
+
+		frequencies['a'] = 1000;
+		REQUIRE(tree.chooseBlockType(frequencies, 1000, options.frontEnd) == DPLKYL002::HuffmanTree::BLOCK_SINGLE);
+
+		frequencies['b'] = 10;
+		REQUIRE(tree.chooseBlockType(frequencies, 1010, options.frontEnd) == DPLKYL002::HuffmanTree::BLOCK_HUFFMAN);
+
+		fill(frequencies.begin(), frequencies.end(), 4);
+		REQUIRE(tree.chooseBlockType(frequencies, 1024, options.frontEnd) == DPLKYL002::HuffmanTree::BLOCK_STORED);
+
+	}
+
+}
+
+TEST_CASE("TESTING COMPRESSED SIZE ESTIMATION:") {
+
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+
+	string text = sampleText() + string(5000, ' ') + sampleText();
+	DPLKYL002::HuffmanTree::bufferType input(text.begin(), text.end());
+
+	SECTION("Check estimate equals the compressed size:") {
+
+		for (unsigned int blockSize : { 100, 4096, 5000, 1 << 20 }) {
+
+			for (bool splitBlocks : { false, true }) {
+
+				DPLKYL002::HuffmanTree::bufferType output;
+
+				options.blockSize = blockSize;
+				options.splitBlocks = splitBlocks;
+				tree.compressBuffer(input, output, options);
+
+				REQUIRE(tree.estimateCompressedSize(input, options) == output.size());
+
+			}
+
+		}
+
+	}
+
+	SECTION("Check estimate of empty input:") {
+
+		DPLKYL002::HuffmanTree::bufferType empty, output;
+
+		tree.compressBuffer(empty, output, options);
+
+		REQUIRE(tree.estimateCompressedSize(empty, options) == output.size());
+
+	}
+
+}
+
+TEST_CASE("TESTING TRAINED TABLES:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+
+	writeTestFile("corpus1.txt", sampleText());
+	writeTestFile("corpus2.txt", "It was the age of wisdom, it was the age of foolishness.\r\n");
+
+	vector<string> corpus = { "corpus1.txt", "corpus2.txt" };
+	unsigned int tableId = tree.trainTable(corpus, ".");
+
+	options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_TRAINED;
+	options.tableId = tableId;
+
+	SECTION("Check the table is saved under its ID:") {
+
+		DPLKYL002::HuffmanTree::StaticTable staticTable;
+
+		REQUIRE(tableId != 0);
+		REQUIRE(tree.trainTable(corpus, ".") == tableId);
+		REQUIRE(tree.loadTable(".", tableId, staticTable));
+		REQUIRE(staticTable.codeLengths.size() == 256);
+
+	}
+
+	SECTION("Check small messages round trip with no per-file table:") {
+
+		string message = "It was the season of Light, it was the season of Darkness.";
+		DPLKYL002::HuffmanTree::bufferType input(message.begin(), message.end());
+		DPLKYL002::HuffmanTree::bufferType output, decoded, bytesOutput;
+
+		tree.compressBuffer(input, output, options);
+		REQUIRE(tree.decompressBuffer(output, decoded, options));
+		REQUIRE(decoded == input);
+
+		DPLKYL002::HuffmanTree::Options bytesOptions;
+		tree.compressBuffer(input, bytesOutput, bytesOptions);
+
+		REQUIRE(output.size() < bytesOutput.size());
+		REQUIRE(output.size() < 8 + 4 + 4 + 9 + input.size() * 5 / 8 + 4);
+
+	}
+
+	SECTION("Check letters missing from the corpus can still be coded:") {
+
+		DPLKYL002::HuffmanTree::bufferType input, output, decoded;
+
+		for (unsigned int i = 0; i < 3000; i++) {
+
+			input.push_back((unsigned char) (i * 7));
+
+		}
+
+		options.blockSize = 1000;
+		tree.compressBuffer(input, output, options);
+
+		REQUIRE(tree.decompressBuffer(output, decoded, options));
+		REQUIRE(decoded == input);
+
+	}
+
+	SECTION("Check decompressing without the table fails:") {
+
+		string message = "It was the best of times.";
+		DPLKYL002::HuffmanTree::bufferType input(message.begin(), message.end());
+		DPLKYL002::HuffmanTree::bufferType output, decoded;
+
+		tree.compressBuffer(input, output, options);
+		options.tableDirectory = "missing_tables";
+
+		REQUIRE_FALSE(tree.decompressBuffer(output, decoded, options));
+
+	}
+
+	SECTION("Check compressing without the table fails:") {
+
+		DPLKYL002::HuffmanTree::bufferType input(100, 'a'), output;
+
+		options.tableDirectory = "missing_tables";
+
+		REQUIRE_FALSE(tree.compressBuffer(input, output, options));
+		REQUIRE(output.empty());
+
+		// both the pipelined and the whole-file paths, neither writing an output file
+		REQUIRE_FALSE(tree.compressContainer("corpus1.txt", "tables_output", options));
+
+		options.splitBlocks = true;
+
+		REQUIRE_FALSE(tree.compressContainer("corpus1.txt", "tables_output", options));
+		REQUIRE_FALSE(ifstream("tables_output").is_open());
+
+	}
+
+}
+
+TEST_CASE("TESTING BUILT-IN ENGLISH MODEL:") {
+
+	DPLKYL002::HuffmanTree tree;
+	const DPLKYL002::EnglishModel::Code & model = DPLKYL002::EnglishModel::code;
+
+	SECTION("Check the compile-time code is complete and prefix free:") {
+
+		unsigned long long kraftSum = 0;
+
+		for (unsigned int s = 0; s < 256; s++) {
+
+			REQUIRE(model.codeLengths[s] >= 1);
+			REQUIRE(model.codeLengths[s] <= DPLKYL002::EnglishModel::maxCodeLength);
+
+			kraftSum += 1ull << (DPLKYL002::EnglishModel::maxCodeLength
+					- model.codeLengths[s]);
+
+		}
+
+		REQUIRE(kraftSum == (1ull << DPLKYL002::EnglishModel::maxCodeLength));
+		REQUIRE(model.codeLengths[' '] < model.codeLengths['z']);
+
+	}
+
+	SECTION("Check tiny messages have no header:") {
+
+		string message = "Hello, world!";
+		DPLKYL002::HuffmanTree::bufferType output, decoded;
+
+		tree.encodeEnglish((const unsigned char *) message.data(), message.size(),
+				output);
+
+		REQUIRE(output.size() < message.size());
+		REQUIRE(output[0] == message.size());
+
+		REQUIRE(tree.decodeEnglish(output.data(), output.size(), decoded));
+		REQUIRE(string(decoded.begin(), decoded.end()) == message);
+
+	}
+
+	SECTION("Check every byte value round trips:") {
+
+		DPLKYL002::HuffmanTree::bufferType input, output, decoded;
+
+		for (unsigned int i = 0; i < 1000; i++) {
+
+			input.push_back((unsigned char) (i * 13));
+
+		}
+
+		tree.encodeEnglish(input.data(), input.size(), output);
+
+		REQUIRE(tree.decodeEnglish(output.data(), output.size(), decoded));
+		REQUIRE(decoded == input);
+
+	}
+
+	SECTION("Check English text compresses:") {
+
+		string text = sampleText();
+		DPLKYL002::HuffmanTree::bufferType output, decoded;
+
+		tree.encodeEnglish((const unsigned char *) text.data(), text.size(), output);
+
+		REQUIRE(output.size() < text.size() * 5 / 8);
+		REQUIRE(tree.decodeEnglish(output.data(), output.size(), decoded));
+		REQUIRE(string(decoded.begin(), decoded.end()) == text);
+
+	}
+
+	SECTION("Check truncated messages are rejected:") {
+
+		DPLKYL002::HuffmanTree::bufferType output, decoded;
+		string message = "It was the best of times";
+
+		tree.encodeEnglish((const unsigned char *) message.data(), message.size(),
+				output);
+		output.resize(output.size() / 2);
+
+		REQUIRE_FALSE(tree.decodeEnglish(output.data(), output.size(), decoded));
+
+	}
+
+}
+
+TEST_CASE("TESTING DECODE TABLE CACHE:") {
+
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+
+	string block = sampleText().substr(0, 4096), text;
+
+	for (int i = 0; i < 4; i++) {
+
+		text += block;
+
+	}
+
+	DPLKYL002::HuffmanTree::bufferType input(text.begin(), text.end());
+	DPLKYL002::HuffmanTree::bufferType output;
+
+	// identical blocks share one code table
+	options.blockSize = block.size();
+	tree.compressBuffer(input, output, options);
+
+	SECTION("Check repeated tables are built once:") {
+
+		DPLKYL002::HuffmanTree::bufferType decoded;
+
+		tree.decodeTableCache.setCapacity(0);
+		tree.decodeTableCache.setCapacity(64);
+
+		unsigned long long misses = tree.decodeTableCache.getMisses();
+		unsigned long long hits = tree.decodeTableCache.getHits();
+
+		REQUIRE(tree.decompressBuffer(output, decoded));
+		REQUIRE(decoded == input);
+
+		REQUIRE(tree.decodeTableCache.getMisses() == misses + 1);
+		REQUIRE(tree.decodeTableCache.getHits() == hits + 3);
+
+	}
+
+	SECTION("Check tables are shared between decoders:") {
+
+		vector<unsigned char> codeLengths = { 1, 2, 3, 3 };
+
+		shared_ptr<const DPLKYL002::HuffmanTree::DecodeTable> first =
+				tree.findDecodeTable(codeLengths);
+		shared_ptr<const DPLKYL002::HuffmanTree::DecodeTable> second =
+				DPLKYL002::HuffmanTree().findDecodeTable(codeLengths);
+
+		REQUIRE(first != nullptr);
+		REQUIRE(first == second);
+
+		vector<unsigned char> invalid = { 1, 1, 1 };
+
+		REQUIRE(tree.findDecodeTable(invalid) == nullptr);
+
+	}
+
+	SECTION("Check the least recently used table is dropped:") {
+
+		tree.decodeTableCache.setCapacity(2);
+
+		vector<unsigned char> a = { 1, 1 }, b = { 1, 2, 2 }, c = { 2, 2, 2, 2 };
+
+		shared_ptr<const DPLKYL002::HuffmanTree::DecodeTable> tableA =
+				tree.findDecodeTable(a);
+
+		tree.findDecodeTable(b);
+		tree.findDecodeTable(a); // b is now the least recently used
+		tree.findDecodeTable(c);
+
+		unsigned long long misses = tree.decodeTableCache.getMisses();
+
+		REQUIRE(tree.findDecodeTable(a) == tableA);
+		REQUIRE(tree.decodeTableCache.getMisses() == misses);
+
+		tree.findDecodeTable(b);
+
+		REQUIRE(tree.decodeTableCache.getMisses() == misses + 1);
+
+		tree.decodeTableCache.setCapacity(64);
+
+	}
+
+}
+
+TEST_CASE("TESTING BATCH COMPRESSION:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+
+	// short records, as from a log or message queue
+	vector<string> records;
+
+	for (int i = 0; i < 2000; i++) {
+
+		records.push_back("record " + to_string(i) + ": it was the best of times");
+
+	}
+
+	records.push_back("");
+
+	vector<DPLKYL002::HuffmanTree::Span> inputs;
+
+	for (const auto & record : records) {
+
+		inputs.push_back(DPLKYL002::HuffmanTree::Span(
+				(const unsigned char *) record.data(), record.size()));
+
+	}
+
+	SECTION("Check every record round trips:") {
+
+		DPLKYL002::HuffmanTree::bufferType header;
+		vector<DPLKYL002::HuffmanTree::bufferType> outputs, decoded;
+
+		tree.compressBatch(inputs, header, outputs, options);
+
+		REQUIRE(outputs.size() == records.size());
+
+		vector<DPLKYL002::HuffmanTree::Span> compressed;
+		size_t compressedSize = 0, originalSize = 0;
+
+		for (size_t r = 0; r < outputs.size(); r++) {
+
+			compressed.push_back(DPLKYL002::HuffmanTree::Span(outputs[r].data(),
+					outputs[r].size()));
+			compressedSize += outputs[r].size();
+			originalSize += records[r].size();
+
+		}
+
+		REQUIRE(compressedSize < originalSize * 3 / 4);
+
+		REQUIRE(tree.decompressBatch(header, compressed, decoded, options));
+		REQUIRE(decoded.size() == records.size());
+
+		for (size_t r = 0; r < records.size(); r++) {
+
+			REQUIRE(string(decoded[r].begin(), decoded[r].end()) == records[r]);
+
+		}
+
+	}
+
+	SECTION("Check large batches split over threads give the same output:") {
+
+		vector<DPLKYL002::HuffmanTree::Span> large;
+
+		while (large.size() < 20 * inputs.size()) {
+
+			large.insert(large.end(), inputs.begin(), inputs.end());
+
+		}
+
+		DPLKYL002::HuffmanTree::bufferType serialHeader, parallelHeader;
+		vector<DPLKYL002::HuffmanTree::bufferType> serial, parallel, decoded;
+
+		options.threads = 1;
+		tree.compressBatch(large, serialHeader, serial, options);
+
+		options.threads = 4;
+		tree.compressBatch(large, parallelHeader, parallel, options);
+
+		REQUIRE(serialHeader == parallelHeader);
+		REQUIRE(serial == parallel);
+
+		vector<DPLKYL002::HuffmanTree::Span> compressed;
+
+		for (const auto & output : parallel) {
+
+			compressed.push_back(DPLKYL002::HuffmanTree::Span(output.data(),
+					output.size()));
+
+		}
+
+		REQUIRE(tree.decompressBatch(parallelHeader, compressed, decoded, options));
+		REQUIRE(decoded.size() == large.size());
+		REQUIRE(string(decoded.back().begin(), decoded.back().end()) == records.back());
+		REQUIRE(string(decoded[1].begin(), decoded[1].end()) == records[1]);
+
+	}
+
+	SECTION("Check an empty batch and a corrupt record:") {
+
+		vector<DPLKYL002::HuffmanTree::Span> empty;
+		DPLKYL002::HuffmanTree::bufferType header;
+		vector<DPLKYL002::HuffmanTree::bufferType> outputs, decoded;
+
+		tree.compressBatch(empty, header, outputs, options);
+
+		REQUIRE(outputs.empty());
+		REQUIRE(tree.decompressBatch(header, empty, decoded, options));
+
+		tree.compressBatch(inputs, header, outputs, options);
+
+		vector<DPLKYL002::HuffmanTree::Span> truncated(1,
+				DPLKYL002::HuffmanTree::Span(outputs[0].data(), 2));
+
+		REQUIRE_FALSE(tree.decompressBatch(header, truncated, decoded, options));
+
+	}
+
+}
+
+TEST_CASE("TESTING LANE-PARALLEL RECORD DECODING:") {
+
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+
+	// records of mixed lengths, including empty ones
+	string text = sampleText();
+	vector<string> records;
+
+	for (size_t i = 0; i < 500; i++) {
+
+		records.push_back(text.substr((i * 37) % 1000, (i * 13) % 211));
+
+	}
+
+	vector<DPLKYL002::HuffmanTree::Span> inputs, compressed;
+	DPLKYL002::HuffmanTree::bufferType header;
+	vector<DPLKYL002::HuffmanTree::bufferType> outputs;
+
+	for (const auto & record : records) {
+
+		inputs.push_back(DPLKYL002::HuffmanTree::Span(
+				(const unsigned char *) record.data(), record.size()));
+
+	}
+
+	tree.compressBatch(inputs, header, outputs, options);
+
+	for (const auto & output : outputs) {
+
+		compressed.push_back(DPLKYL002::HuffmanTree::Span(output.data(),
+				output.size()));
+
+	}
+
+	DPLKYL002::BitReader headerReader(header.data(), header.size());
+	vector<unsigned char> codeLengths;
+
+	REQUIRE(tree.readCodeLengths(headerReader, codeLengths));
+
+	shared_ptr<const DPLKYL002::HuffmanTree::DecodeTable> table =
+			tree.findDecodeTable(codeLengths);
+
+	REQUIRE(table != nullptr);
+	REQUIRE(table->isSingleLookup());
+
+	SECTION("Check lanes decode the same records as the scalar decoder:") {
+
+		vector<DPLKYL002::HuffmanTree::bufferType> decoded(records.size());
+
+		REQUIRE(tree.decodeRecords(*table, compressed, decoded, 0, records.size()));
+
+		for (size_t r = 0; r < records.size(); r++) {
+
+			DPLKYL002::HuffmanTree::bufferType scalar;
+
+			REQUIRE(tree.decodeRecord(*table, compressed[r].data, compressed[r].size,
+					scalar));
+			REQUIRE(decoded[r] == scalar);
+			REQUIRE(string(decoded[r].begin(), decoded[r].end()) == records[r]);
+
+		}
+
+	}
+
+	SECTION("Check partly filled lane groups:") {
+
+		for (unsigned int numRecords = 0;
+				numRecords <= DPLKYL002::HuffmanTree::numLanes; numRecords++) {
+
+			vector<DPLKYL002::HuffmanTree::bufferType> decoded(numRecords);
+			vector<DPLKYL002::HuffmanTree::bufferType *> laneOutputs;
+
+			for (auto & output : decoded) {
+
+				laneOutputs.push_back(&output);
+
+			}
+
+			REQUIRE(tree.decodeRecordLanes(*table, compressed.data() + 100,
+					laneOutputs.data(), numRecords));
+
+			for (unsigned int lane = 0; lane < numRecords; lane++) {
+
+				REQUIRE(string(decoded[lane].begin(), decoded[lane].end())
+						== records[100 + lane]);
+
+			}
+
+		}
+
+	}
+
+	SECTION("Check a record cut short is rejected:") {
+
+		vector<DPLKYL002::HuffmanTree::Span> damaged(compressed.begin() + 200,
+				compressed.begin() + 208);
+		vector<DPLKYL002::HuffmanTree::bufferType> decoded(damaged.size());
+
+		// drop the last byte of a long record, but keep its letter count
+		size_t longest = 0;
+
+		for (size_t r = 0; r < damaged.size(); r++) {
+
+			if (damaged[r].size > damaged[longest].size) {
+
+				longest = r;
+
+			}
+
+		}
+
+		damaged[longest].size -= 2;
+
+		REQUIRE_FALSE(tree.decodeRecords(*table, damaged, decoded, 0,
+				damaged.size()));
+
+	}
+
+}
+
+TEST_CASE("TESTING ENCODER AND DECODER KERNELS:") {
+
+	DPLKYL002::HuffmanTree tree;
+
+	string text = sampleText();
+
+	// a skewed code with lengths up to the limit
+	vector<unsigned int> frequencies(256, 1);
+
+	for (unsigned char letter : text) {
+
+		frequencies[letter] += 1000;
+
+	}
+
+	vector<unsigned char> codeLengths;
+	vector<unsigned int> codes, packedCodes;
+
+	tree.buildCodeLengths(frequencies, codeLengths);
+	tree.buildCanonicalCodes(codeLengths, codes);
+	tree.packCodes(codes, codeLengths, packedCodes);
+
+	shared_ptr<const DPLKYL002::HuffmanTree::DecodeTable> table =
+			tree.findDecodeTable(codeLengths);
+
+	REQUIRE(*max_element(codeLengths.begin(), codeLengths.end())
+			> DPLKYL002::HuffmanTree::DecodeTable::lookupBits);
+
+	// every byte value, then English text
+	DPLKYL002::HuffmanTree::bufferType input;
+
+	for (unsigned int i = 0; i < 512; i++) {
+
+		input.push_back((unsigned char) (i * 7));
+
+	}
+
+	input.insert(input.end(), text.begin(), text.end());
+
+	SECTION("Check the kernels write the same bits as BitWriter:") {
+
+		for (size_t size : { (size_t) 0, (size_t) 7, (size_t) 64, (size_t) 1001,
+				input.size() }) {
+
+			for (unsigned int offset = 0; offset < 8; offset++) {
+
+				DPLKYL002::HuffmanTree::bufferType expected, actual;
+				DPLKYL002::BitWriter expectedWriter(expected), actualWriter(actual);
+
+				expectedWriter.writeBits(0x55, offset);
+				actualWriter.writeBits(0x55, offset);
+
+				for (size_t i = 0; i < size; i++) {
+
+					expectedWriter.writeBits(codes[input[i]], codeLengths[input[i]]);
+
+				}
+
+				tree.encodeSymbols(input.data(), size, packedCodes.data(),
+						actualWriter);
+
+				REQUIRE(actualWriter.getPosition() == expectedWriter.getPosition());
+
+				expectedWriter.writeBits(0x3, 2);
+				actualWriter.writeBits(0x3, 2);
+				expectedWriter.flush();
+				actualWriter.flush();
+
+				REQUIRE(actual == expected);
+
+				// and decode them back, long codes included
+				DPLKYL002::BitReader reader(actual.data(), actual.size(), offset);
+				DPLKYL002::HuffmanTree::bufferType decoded(size);
+
+				tree.decodeSymbols(*table, reader, decoded.data(), size);
+
+				REQUIRE(std::equal(decoded.begin(), decoded.end(), input.begin()));
+				REQUIRE(reader.readBits(2) == 0x3);
+
+			}
+
+		}
+
+	}
+
+	SECTION("Check a large input (the letter pair table without AVX2):") {
+
+		DPLKYL002::HuffmanTree::bufferType large, expected, actual;
+
+		while (large.size() < DPLKYL002::HuffmanTree::pairTableThreshold + 3) {
+
+			large.insert(large.end(), input.begin(), input.end());
+
+		}
+
+		DPLKYL002::BitWriter expectedWriter(expected), actualWriter(actual);
+
+		for (unsigned char letter : large) {
+
+			expectedWriter.writeBits(codes[letter], codeLengths[letter]);
+
+		}
+
+		tree.encodeSymbols(large.data(), large.size(), packedCodes.data(),
+				actualWriter);
+		expectedWriter.flush();
+		actualWriter.flush();
+
+		REQUIRE(actual == expected);
+
+	}
+
+}
+
+TEST_CASE("TESTING PARALLEL ENCODING:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+
+	// a few chunks' worth of text, with every byte value somewhere
+	DPLKYL002::HuffmanTree::bufferType input;
+	string text = sampleText();
+
+	for (unsigned int i = 0; i < 256; i++) {
+
+		input.push_back((unsigned char) i);
+
+	}
+
+	while (input.size() < 5 * DPLKYL002::HuffmanTree::encodeChunkSize + 13) {
+
+		input.insert(input.end(), text.begin(), text.end());
+
+	}
+
+	vector<unsigned int> frequencies(256, 1);
+
+	for (unsigned char letter : input) {
+
+		frequencies[letter]++;
+
+	}
+
+	vector<unsigned char> codeLengths;
+	vector<unsigned int> codes, packedCodes;
+
+	tree.buildCodeLengths(frequencies, codeLengths);
+	tree.buildCanonicalCodes(codeLengths, codes);
+	tree.packCodes(codes, codeLengths, packedCodes);
+
+	SECTION("Check every thread count gives the serial encoder's bits:") {
+
+		for (unsigned int threads : { 1u, 2u, 3u, 5u, 8u }) {
+
+			for (unsigned int offset : { 0u, 3u, 7u }) {
+
+				DPLKYL002::HuffmanTree::bufferType expected, actual;
+				DPLKYL002::BitWriter expectedWriter(expected), actualWriter(actual);
+
+				expectedWriter.writeBits(0x5, offset);
+				actualWriter.writeBits(0x5, offset);
+
+				tree.encodeSymbols(input.data(), input.size(), packedCodes.data(),
+						expectedWriter);
+				tree.encodeSymbolsParallel(input.data(), input.size(),
+						packedCodes.data(), actualWriter, threads);
+
+				REQUIRE(actualWriter.getPosition() == expectedWriter.getPosition());
+
+				expectedWriter.writeBits(0x1, 1);
+				actualWriter.writeBits(0x1, 1);
+				expectedWriter.flush();
+				actualWriter.flush();
+
+				REQUIRE(actual == expected);
+
+			}
+
+		}
+
+	}
+
+	SECTION("Check a single block container does not depend on the thread count:") {
+
+		DPLKYL002::HuffmanTree::Options options;
+		DPLKYL002::HuffmanTree::bufferType serial, parallel, decompressed;
+
+		options.blockSize = input.size();
+		options.threads = 1;
+		tree.compressBuffer(input, serial, options);
+
+		options.threads = 4;
+		tree.compressBuffer(input, parallel, options);
+
+		REQUIRE(parallel == serial);
+		REQUIRE(tree.decompressBuffer(parallel, decompressed));
+		REQUIRE(decompressed == input);
+
+	}
+
+}
+
+TEST_CASE("TESTING SPECULATIVE PARALLEL DECODING:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+
+	SECTION("Check every thread count decodes the same letters:") {
+
+		// a legacy code table (code -> letter) with codes of 1 to 5 bits
+		unordered_map<string, string> map = { { "0", "e" }, { "10", "t" }, { "110",
+				"a" }, { "1110", "\n" }, { "11110", "x" }, { "11111", "z" } };
+		vector<int> links;
+
+		tree.buildLegacyCode(map, links);
+
+		// several chunks of letters, packed most significant bit first
+		string letters = "etaexe\nzte", bitString;
+		string expected;
+		unsigned int seed = 1;
+
+		while (bitString.size() < 5 * DPLKYL002::HuffmanTree::speculativeChunkBits
+				+ 11) {
+
+			seed = seed * 1103515245 + 12345;
+			char letter = letters[(seed >> 16) % letters.size()];
+
+			for (const auto & field : map) {
+
+				if (field.second[0] == letter) {
+
+					bitString += field.first;
+
+				}
+
+			}
+
+			expected += letter;
+
+		}
+
+		DPLKYL002::HuffmanTree::bufferType data((bitString.size() + 7) / 8, 0);
+
+		for (size_t i = 0; i < bitString.size(); i++) {
+
+			data[i / 8] |= (bitString[i] == '1') << (7 - i % 8);
+
+		}
+
+		for (unsigned int threads : { 1u, 2u, 3u, 7u }) {
+
+			string decoded;
+
+			tree.decodeLegacyStream(links, data.data(), bitString.size(), decoded,
+					threads);
+
+			REQUIRE(decoded == expected);
+
+		}
+
+		// a stream cut short ends at the last whole code
+		string decoded;
+
+		tree.decodeLegacyStream(links, data.data(), 4, decoded, 4);
+
+		REQUIRE(decoded == expected.substr(0, decoded.size()));
+		REQUIRE(decoded.size() >= 1);
+
+	}
+
+	SECTION("Check chunks which never fall into step are decoded serially:") {
+
+		// two bit codes only: a chunk starting on an odd bit stays out of step for good
+		unordered_map<string, string> map = { { "00", "a" }, { "01", "b" }, { "10",
+				"c" }, { "11", "d" } };
+		vector<int> links;
+		string expected;
+
+		tree.buildLegacyCode(map, links);
+
+		// 3 chunks of an odd number of bits each
+		unsigned long long numBits = 3 * (DPLKYL002::HuffmanTree::speculativeChunkBits + 1);
+		DPLKYL002::HuffmanTree::bufferType data((numBits + 7) / 8, 0);
+		unsigned int seed = 7;
+
+		for (size_t i = 0; i < data.size(); i++) {
+
+			seed = seed * 1103515245 + 12345;
+			data[i] = seed >> 16;
+
+		}
+
+		for (unsigned long long bit = 0; bit + 1 < numBits; bit += 2) {
+
+			expected += "abcd"[(data[bit / 8] >> (6 - bit % 8)) & 3];
+
+		}
+
+		string decoded;
+
+		tree.decodeLegacyStream(links, data.data(), numBits, decoded, 3);
+
+		REQUIRE(decoded == expected);
+
+	}
+
+	SECTION("Check a large legacy file decompresses on several threads:") {
+
+		string text = sampleText(), input;
+
+		while (input.size() < 1 << 20) {
+
+			input += text;
+
+		}
+
+		writeTestFile("speculative_input.txt", input);
+
+		DPLKYL002::HuffmanTree::Options options;
+		options.threads = 4;
+
+		tree.compress("speculative_input.txt", "speculative_output");
+		tree.decompress("speculative_output", "speculative_decompressed.txt",
+				options);
+
+		REQUIRE(readTestFile("speculative_decompressed.txt") == input);
+
+	}
+
+}
+
+TEST_CASE("TESTING PIPELINED COMPRESSION:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+
+	SECTION("Check the pipeline writes the same container as compressBuffer:") {
+
+		string text = sampleText();
+
+		DPLKYL002::HuffmanTree::FrontEnd frontEnds[] = {
+				DPLKYL002::HuffmanTree::FRONT_END_BYTES,
+				DPLKYL002::HuffmanTree::FRONT_END_LZ77,
+				DPLKYL002::HuffmanTree::FRONT_END_BWT };
+
+		// many blocks, blocks which end with the file, one block and no blocks
+		for (string input : { text, text.substr(0, 12000), text.substr(0, 777),
+				string() }) {
+
+			writeTestFile("pipeline_input.txt", input);
+
+			DPLKYL002::HuffmanTree::bufferType buffer(input.begin(), input.end());
+
+			for (auto frontEnd : frontEnds) {
+
+				for (unsigned int threads : { 1u, 3u }) {
+
+					DPLKYL002::HuffmanTree::Options options;
+					DPLKYL002::HuffmanTree::bufferType expected, actual, decompressed;
+
+					options.frontEnd = frontEnd;
+					options.blockSize = 1000;
+					options.threads = threads;
+
+					tree.compressBuffer(buffer, expected, options);
+
+					REQUIRE(tree.compressStream("pipeline_input.txt",
+							"pipeline_output", options));
+					REQUIRE(tree.readFile("pipeline_output", actual));
+					REQUIRE(actual == expected);
+
+					REQUIRE(tree.decompressBuffer(actual, decompressed));
+					REQUIRE(decompressed == buffer);
+
+				}
+
+			}
+
+		}
+
+	}
+
+	SECTION("Check a closed queue hands out what is left, then stops:") {
+
+		DPLKYL002::BoundedQueue<int> queue(2);
+		int item;
+
+		REQUIRE(queue.push(1));
+		REQUIRE(queue.push(2));
+
+		queue.close();
+
+		REQUIRE_FALSE(queue.push(3));
+		REQUIRE(queue.pop(item));
+		REQUIRE(item == 1);
+		REQUIRE(queue.pop(item));
+		REQUIRE(item == 2);
+		REQUIRE_FALSE(queue.pop(item));
+
+	}
+
+	SECTION("Check a missing input file is reported:") {
+
+		DPLKYL002::HuffmanTree::Options options;
+
+		REQUIRE_FALSE(tree.compressStream("no_such_file.txt", "pipeline_output",
+				options));
+
+	}
+
+}
+
+TEST_CASE("TESTING LOCK-FREE RING BUFFERS:") {
+
+	SECTION("Check a ring fills, empties and wraps around:") {
+
+		DPLKYL002::SpscRing<int> spsc(3);
+		DPLKYL002::MpmcRing<int> mpmc(3);
+		int item;
+
+		REQUIRE(spsc.capacity() == 4);
+		REQUIRE(mpmc.capacity() == 4);
+
+		for (int lap = 0; lap < 3; lap++) {
+
+			for (int i = 0; i < 4; i++) {
+
+				REQUIRE(spsc.tryPush(lap * 4 + i));
+				REQUIRE(mpmc.tryPush(lap * 4 + i));
+
+			}
+
+			REQUIRE_FALSE(spsc.tryPush(-1));
+			REQUIRE_FALSE(mpmc.tryPush(-1));
+
+			for (int i = 0; i < 4; i++) {
+
+				REQUIRE(spsc.tryPop(item));
+				REQUIRE(item == lap * 4 + i);
+				REQUIRE(mpmc.tryPop(item));
+				REQUIRE(item == lap * 4 + i);
+
+			}
+
+			REQUIRE_FALSE(spsc.tryPop(item));
+			REQUIRE_FALSE(mpmc.tryPop(item));
+
+		}
+
+	}
+
+	SECTION("Check every item crosses between threads exactly once:") {
+
+		const unsigned int numItems = 200000, numThreads = 3;
+
+		// one producer, one consumer, in order
+		DPLKYL002::SpscRing<unsigned int> spsc(64);
+		bool inOrder = true;
+
+		thread consumer([&]() {
+
+			unsigned int item, expected = 0;
+
+			while (expected < numItems) {
+
+				if (spsc.tryPop(item)) {
+
+					inOrder = inOrder && item == expected;
+					expected++;
+
+				} else {
+
+					this_thread::yield();
+
+				}
+
+			}
+
+		});
+
+		for (unsigned int i = 0; i < numItems; i++) {
+
+			while (!spsc.tryPush(i)) {
+
+				this_thread::yield();
+
+			}
+
+		}
+
+		consumer.join();
+
+		REQUIRE(inOrder);
+
+		// several producers and consumers
+		DPLKYL002::MpmcRing<unsigned int> mpmc(64);
+		vector<atomic<unsigned int>> seen(numItems);
+		atomic<unsigned int> received(0);
+		vector<thread> workers;
+
+		for (auto & count : seen) {
+
+			count = 0;
+
+		}
+
+		for (unsigned int t = 0; t < numThreads; t++) {
+
+			workers.push_back(thread([&, t]() {
+
+				for (unsigned int i = t; i < numItems; i += numThreads) {
+
+					while (!mpmc.tryPush(i)) {
+
+						this_thread::yield();
+
+					}
+
+				}
+
+			}));
+
+			workers.push_back(thread([&]() {
+
+				unsigned int item;
+
+				while (received < numItems) {
+
+					if (mpmc.tryPop(item)) {
+
+						seen[item]++;
+						received++;
+
+					} else {
+
+						this_thread::yield();
+
+					}
+
+				}
+
+			}));
+
+		}
+
+		for (auto & worker : workers) {
+
+			worker.join();
+
+		}
+
+		REQUIRE(received == numItems);
+		REQUIRE(all_of(seen.begin(), seen.end(), [](const atomic<unsigned int> & count) {
+
+			return count == 1;
+
+		}));
+
+	}
+
+}
+
+TEST_CASE("TESTING WORK-STEALING THREAD POOL:") {
+
+	SECTION("Check every task runs once, nested tasks included:") {
+
+		DPLKYL002::ThreadPool pool(3);
+		vector<atomic<unsigned int>> runs(64 * 16);
+
+		for (auto & count : runs) {
+
+			count = 0;
+
+		}
+
+		// tasks which wait for tasks of their own
+		pool.forEach(64, [&](size_t outer) {
+
+			pool.forEach(16, [&](size_t inner) {
+
+				runs[outer * 16 + inner]++;
+
+			});
+
+		});
+
+		REQUIRE(all_of(runs.begin(), runs.end(), [](const atomic<unsigned int> & count) {
+
+			return count == 1;
+
+		}));
+
+		DPLKYL002::ThreadPool::TaskGroup group;
+		atomic<unsigned int> done(0);
+
+		for (int i = 0; i < 100; i++) {
+
+			pool.submit(group, [&]() {
+
+				done++;
+
+			});
+
+		}
+
+		pool.wait(group);
+
+		REQUIRE(done == 100);
+		REQUIRE(pool.size() == 3);
+
+	}
+
+	SECTION("Check concurrent callers share the pool and get the same output:") {
+
+		DPLKYL002::ThreadPool::configure(2, true);
+
+		DPLKYL002::HuffmanTree tree;
+		DPLKYL002::HuffmanTree::Options options;
+		string text = sampleText();
+		DPLKYL002::HuffmanTree::bufferType input, expected;
+
+		while (input.size() < 3 * DPLKYL002::HuffmanTree::encodeChunkSize) {
+
+			input.insert(input.end(), text.begin(), text.end());
+
+		}
+
+		options.threads = 1;
+		tree.compressBuffer(input, expected, options);
+
+		vector<DPLKYL002::HuffmanTree::bufferType> outputs(4);
+		vector<thread> callers;
+
+		options.threads = 4;
+
+		for (size_t c = 0; c < outputs.size(); c++) {
+
+			callers.push_back(thread([&, c]() {
+
+				DPLKYL002::HuffmanTree callerTree;
+				callerTree.compressBuffer(input, outputs[c], options);
+
+			}));
+
+		}
+
+		for (auto & caller : callers) {
+
+			caller.join();
+
+		}
+
+		for (const auto & output : outputs) {
+
+			REQUIRE(output == expected);
+
+		}
+
+		DPLKYL002::ThreadPool::configure(max(1u, thread::hardware_concurrency() - 1));
+
+		REQUIRE(DPLKYL002::ThreadPool::shared().size()
+				== max(1u, thread::hardware_concurrency() - 1));
+
+	}
+
+}
+
+TEST_CASE("TESTING I/O BACKENDS:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+
+	DPLKYL002::FileIO::Backend backends[] = {
+			DPLKYL002::FileIO::BACKEND_STREAMS, DPLKYL002::FileIO::BACKEND_PREAD,
+			DPLKYL002::FileIO::BACKEND_URING };
+
+	// many requests, so several are in flight at once, and a short last request
+	string text = sampleText(), input;
+
+	while (input.size() < 12 * DPLKYL002::FileIO::requestSize) {
+
+		input += text;
+
+	}
+
+	input += "tail";
+
+	DPLKYL002::HuffmanTree::bufferType buffer(input.begin(), input.end());
+
+	SECTION("Check every backend reads and writes whole files:") {
+
+		for (auto backend : backends) {
+
+			DPLKYL002::HuffmanTree::Options options;
+			DPLKYL002::HuffmanTree::bufferType actual;
+
+			options.backend = backend;
+
+			REQUIRE(tree.writeFile("backend_input.txt", buffer, options));
+			REQUIRE(readTestFile("backend_input.txt") == input);
+			REQUIRE(tree.readFile("backend_input.txt", actual, options));
+			REQUIRE(actual == buffer);
+
+			// an empty file
+			REQUIRE(tree.writeFile("backend_empty.txt",
+					DPLKYL002::HuffmanTree::bufferType(), options));
+			REQUIRE(tree.readFile("backend_empty.txt", actual, options));
+			REQUIRE(actual.empty());
+
+			REQUIRE_FALSE(tree.readFile("no_such_file.txt", actual, options));
+
+		}
+
+	}
+
+	SECTION("Check reads stop at the end of the file:") {
+
+		writeTestFile("backend_input.txt", input);
+
+		int fd = DPLKYL002::FileIO::openFile("backend_input.txt", false);
+		unsigned long long offset = input.size() - 1000;
+
+		REQUIRE(fd >= 0);
+
+		for (auto backend : backends) {
+
+			DPLKYL002::HuffmanTree::bufferType actual(
+					2 * DPLKYL002::FileIO::requestSize);
+
+			REQUIRE(DPLKYL002::FileIO::readAt(fd, actual.data(), actual.size(),
+					offset, backend) == 1000);
+			REQUIRE(string(actual.begin(), actual.begin() + 1000)
+					== input.substr(offset));
+
+		}
+
+		DPLKYL002::FileIO::closeFile(fd);
+
+	}
+
+	SECTION("Check every backend compresses to the same files:") {
+
+		writeTestFile("backend_input.txt", input);
+
+		string expected, expectedBinary;
+
+		for (auto backend : backends) {
+
+			DPLKYL002::HuffmanTree::Options options;
+			options.backend = backend;
+			options.blockSize = 1 << 18;
+
+			// the block container, through the pipeline
+			tree.compressContainer("backend_input.txt", "backend_output", options);
+			tree.decompressContainer("backend_output", "backend_decompressed.txt",
+					options);
+
+			REQUIRE(readTestFile("backend_decompressed.txt") == input);
+
+			if (backend == DPLKYL002::FileIO::BACKEND_STREAMS) {
+
+				expected = readTestFile("backend_output");
+
+			}
+
+			REQUIRE(readTestFile("backend_output") == expected);
+
+			// the legacy .hdr / .bin files
+			tree.compress("backend_input.txt", "backend_legacy", options);
+			tree.decompress("backend_legacy", "backend_decompressed.txt", options);
+
+			REQUIRE(readTestFile("backend_decompressed.txt") == input);
+
+			if (backend == DPLKYL002::FileIO::BACKEND_STREAMS) {
+
+				expectedBinary = readTestFile("backend_legacy.bin");
+
+			}
+
+			REQUIRE(readTestFile("backend_legacy.bin") == expectedBinary);
+
+		}
+
+	}
+
+}
+
+TEST_CASE("TESTING DIRECT I/O:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+
+	DPLKYL002::FileIO::Backend backends[] = {
+			DPLKYL002::FileIO::BACKEND_STREAMS, DPLKYL002::FileIO::BACKEND_PREAD,
+			DPLKYL002::FileIO::BACKEND_URING };
+
+	string text = sampleText(), input;
+
+	while (input.size() < 3 * DPLKYL002::FileIO::directBufferSize / 2) {
+
+		input += text;
+
+	}
+
+	SECTION("Check aligned buffers are aligned:") {
+
+		for (bool hugePages : { false, true }) {
+
+			DPLKYL002::FileIO::AlignedBuffer buffer(5000, hugePages);
+
+			REQUIRE(((size_t) buffer.data() % DPLKYL002::FileIO::directAlignment) == 0);
+			REQUIRE(buffer.size() == 2 * DPLKYL002::FileIO::directAlignment);
+
+			buffer.data()[buffer.size() - 1] = 1;
+
+		}
+
+	}
+
+	SECTION("Check whole files of every size round trip:") {
+
+		size_t alignment = DPLKYL002::FileIO::directAlignment;
+
+		// empty, shorter than a block, whole blocks, an unaligned tail, several staging buffers
+		for (size_t size : { (size_t) 0, (size_t) 1, alignment - 1, alignment, alignment + 1,
+				input.size() }) {
+
+			DPLKYL002::HuffmanTree::bufferType buffer(input.begin(),
+					input.begin() + size), actual;
+
+			for (auto backend : backends) {
+
+				DPLKYL002::HuffmanTree::Options options;
+				options.backend = backend;
+				options.directIO = true;
+				options.hugePages = backend == DPLKYL002::FileIO::BACKEND_URING;
+
+				REQUIRE(tree.writeFile("direct_input.txt", buffer, options));
+				REQUIRE(readTestFile("direct_input.txt") == input.substr(0, size));
+				REQUIRE(tree.readFile("direct_input.txt", actual, options));
+				REQUIRE(actual == buffer);
+
+			}
+
+		}
+
+	}
+
+	SECTION("Check small unaligned writes and reads through a small staging buffer:") {
+
+		int fd = DPLKYL002::FileIO::openFile("direct_input.txt", true, true);
+
+		REQUIRE(fd >= 0);
+
+		DPLKYL002::FileIO::DirectWriter writer(fd,
+				DPLKYL002::FileIO::BACKEND_PREAD, 3 * DPLKYL002::FileIO::directAlignment);
+		size_t position = 0;
+
+		for (size_t length = 1; position < 100000; length = length * 3 % 7919 + 1) {
+
+			length = min(length, input.size() - position);
+
+			REQUIRE(writer.write((const unsigned char *) input.data() + position,
+					length));
+			position += length;
+
+		}
+
+		REQUIRE(writer.finish());
+		DPLKYL002::FileIO::closeFile(fd);
+
+		REQUIRE(readTestFile("direct_input.txt") == input.substr(0, position));
+
+		fd = DPLKYL002::FileIO::openFile("direct_input.txt", false, true);
+
+		REQUIRE(fd >= 0);
+
+		DPLKYL002::FileIO::DirectReader reader(fd,
+				DPLKYL002::FileIO::BACKEND_URING, DPLKYL002::FileIO::directAlignment);
+		string actual;
+		char piece[5000];
+
+		for (long long numRead = 1; numRead > 0;) {
+
+			numRead = reader.read((unsigned char *) piece, sizeof(piece));
+
+			REQUIRE(numRead >= 0);
+			actual.append(piece, numRead);
+
+		}
+
+		DPLKYL002::FileIO::closeFile(fd);
+
+		REQUIRE(actual == input.substr(0, position));
+
+	}
+
+	SECTION("Check compressed files are the same with and without O_DIRECT:") {
+
+		writeTestFile("direct_input.txt", input);
+
+		DPLKYL002::HuffmanTree::Options options;
+		options.blockSize = 100000;
+
+		tree.compressContainer("direct_input.txt", "direct_expected", options);
+		tree.compress("direct_input.txt", "direct_legacy_expected", options);
+
+		for (auto backend : backends) {
+
+			options.backend = backend;
+			options.directIO = true;
+
+			tree.compressContainer("direct_input.txt", "direct_output", options);
+			tree.decompressContainer("direct_output", "direct_decompressed.txt",
+					options);
+
+			REQUIRE(readTestFile("direct_output") == readTestFile("direct_expected"));
+			REQUIRE(readTestFile("direct_decompressed.txt") == input);
+
+			tree.compress("direct_input.txt", "direct_legacy", options);
+			tree.decompress("direct_legacy", "direct_decompressed.txt", options);
+
+			REQUIRE(readTestFile("direct_legacy.bin")
+					== readTestFile("direct_legacy_expected.bin"));
+			REQUIRE(readTestFile("direct_decompressed.txt") == input);
+
+		}
+
+	}
+
+}
+
+TEST_CASE("TESTING MULTI-FILE COMPRESSION:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	string text = sampleText();
+
+	// a directory tree of files, one of them empty, and a file named on its own
+	REQUIRE(tree.makeDirectories("files_input/nested/deeper"));
+
+	writeTestFile("files_input/a.txt", text);
+	writeTestFile("files_input/b.txt", text.substr(0, 1234));
+	writeTestFile("files_input/nested/c.txt", text + text);
+	writeTestFile("files_input/nested/deeper/d.txt", "");
+	writeTestFile("files_single.txt", text.substr(100, 5000));
+
+	vector<string> paths = { "files_input/", "files_single.txt" };
+
+	SECTION("Check directories are listed in name order:") {
+
+		vector<pair<string, string>> files;
+
+		REQUIRE(tree.listInputFiles("files_input/", files));
+		REQUIRE(tree.listInputFiles("files_single.txt", files));
+		REQUIRE_FALSE(tree.listInputFiles("no_such_file.txt", files));
+
+		REQUIRE(files.size() == 5);
+		REQUIRE(files[0].second == "a.txt");
+		REQUIRE(files[2].first == "files_input/nested/c.txt");
+		REQUIRE(files[2].second == "nested/c.txt");
+		REQUIRE(files[3].second == "nested/deeper/d.txt");
+		REQUIRE(files[4].second == "files_single.txt");
+
+	}
+
+	SECTION("Check every job count compresses every file:") {
+
+		for (unsigned int jobs : { 1u, 3u, 8u }) {
+
+			DPLKYL002::HuffmanTree::Options options;
+			options.blockSize = 4096;
+			options.threads = jobs;
+
+			string outputDirectory = "files_output_" + to_string(jobs);
+			DPLKYL002::HuffmanTree::FilesReport report = tree.compressFiles(paths,
+					outputDirectory, options, jobs);
+
+			REQUIRE(report.numFiles == 5);
+			REQUIRE(report.numFailed == 0);
+			REQUIRE(report.inputBytes == 3 * text.size() + 1234 + 5000);
+			REQUIRE(report.outputBytes > 0);
+
+			for (string name : { "a.txt", "b.txt", "nested/c.txt", "nested/deeper/d.txt" }) {
+
+				DPLKYL002::HuffmanTree::bufferType compressed, decompressed;
+
+				REQUIRE(tree.readFile(outputDirectory + "/" + name
+						+ DPLKYL002::HuffmanTree::containerExtension, compressed));
+				REQUIRE(tree.decompressBuffer(compressed, decompressed));
+				REQUIRE(string(decompressed.begin(), decompressed.end())
+						== readTestFile("files_input/" + name));
+
+			}
+
+			REQUIRE(readTestFile(outputDirectory + "/files_single.txt"
+					+ DPLKYL002::HuffmanTree::containerExtension)
+					== readTestFile("files_output_1/files_single.txt"
+							+ DPLKYL002::HuffmanTree::containerExtension));
+
+		}
+
+	}
+
+	SECTION("Check missing inputs are counted as failures:") {
+
+		DPLKYL002::HuffmanTree::Options options;
+		DPLKYL002::HuffmanTree::FilesReport report = tree.compressFiles(
+				{ "files_single.txt", "no_such_file.txt" }, "files_output_missing",
+				options, 2);
+
+		REQUIRE(report.numFiles == 2);
+		REQUIRE(report.numFailed == 1);
+		REQUIRE(report.inputBytes == 5000);
+
+	}
+
+	SECTION("Check inputs sharing an output name are counted as failures:") {
+
+		DPLKYL002::HuffmanTree::Options options;
+
+		REQUIRE(tree.makeDirectories("files_other"));
+		writeTestFile("files_other/a.txt", "another a.txt");
+
+		DPLKYL002::HuffmanTree::FilesReport report = tree.compressFiles(
+				{ "files_input/a.txt", "files_other/a.txt" }, "files_output_duplicate",
+				options, 2);
+
+		REQUIRE(report.numFiles == 2);
+		REQUIRE(report.numFailed == 1);
+		REQUIRE(report.inputBytes == text.size());
+
+		DPLKYL002::HuffmanTree::bufferType compressed, decompressed;
+
+		REQUIRE(tree.readFile("files_output_duplicate/a.txt"
+				+ DPLKYL002::HuffmanTree::containerExtension, compressed));
+		REQUIRE(tree.decompressBuffer(compressed, decompressed));
+		REQUIRE(string(decompressed.begin(), decompressed.end()) == text);
+
+	}
+
+}
+
+TEST_CASE("TESTING FORMAT DETECTION:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+	string text = sampleText();
+
+	writeTestFile("format_input.txt", text);
+
+	SECTION("Check every format is recognised and decompressed:") {
+
+		options.blockSize = 4096;
+
+		REQUIRE(tree.compressContainer("format_input.txt", "format_container",
+				options));
+		tree.compressGzip("format_input.txt", "format_gzip", options);
+		tree.compress("format_input.txt", "format_legacy");
+
+		options.frontEnd = DPLKYL002::HuffmanTree::FRONT_END_WORDS;
+
+		REQUIRE(tree.compressContainer("format_input.txt", "format_words",
+				options));
+
+		REQUIRE(tree.detectFormat("format_container")
+				== DPLKYL002::HuffmanTree::FORMAT_CONTAINER);
+		REQUIRE(tree.detectFormat("format_words")
+				== DPLKYL002::HuffmanTree::FORMAT_CONTAINER);
+		REQUIRE(tree.detectFormat("format_gzip")
+				== DPLKYL002::HuffmanTree::FORMAT_GZIP);
+		REQUIRE(tree.detectFormat("format_legacy")
+				== DPLKYL002::HuffmanTree::FORMAT_LEGACY);
+		REQUIRE(tree.detectFormat("format_input.txt")
+				== DPLKYL002::HuffmanTree::FORMAT_UNKNOWN);
+		REQUIRE(tree.detectFormat("no_such_file.txt")
+				== DPLKYL002::HuffmanTree::FORMAT_UNKNOWN);
+
+		for (string fileName : { "format_container", "format_words", "format_gzip",
+				"format_legacy" }) {
+
+			DPLKYL002::HuffmanTree::bufferType output;
+
+			REQUIRE(tree.decompressFile(fileName, output));
+			REQUIRE(string(output.begin(), output.end()) == text);
+
+		}
+
+	}
+
+	SECTION("Check empty and missing inputs to the legacy format:") {
+
+		DPLKYL002::HuffmanTree::bufferType output(1, 'x');
+
+		writeTestFile("format_empty.txt", "");
+
+		REQUIRE(tree.compress("format_empty.txt", "format_empty"));
+
+		REQUIRE(readTestFile("format_empty.hdr") == "");
+		REQUIRE(readTestFile("format_empty") == "0\n");
+		REQUIRE(tree.decompressFile("format_empty", output));
+		REQUIRE(output.empty());
+
+		REQUIRE_FALSE(tree.compress("no_such_file.txt", "format_missing"));
+		REQUIRE_FALSE(tree.compressGzip("no_such_file.txt", "format_missing",
+				options));
+
+		REQUIRE(tree.detectFormat("format_missing")
+				== DPLKYL002::HuffmanTree::FORMAT_UNKNOWN);
+
+	}
+
+	SECTION("Check unknown and damaged files are refused:") {
+
+		DPLKYL002::HuffmanTree::bufferType output;
+
+		REQUIRE_FALSE(tree.decompressFile("format_input.txt", output));
+
+		writeTestFile("format_damaged", "DPLH\x01");
+
+		REQUIRE_FALSE(tree.decompressFile("format_damaged", output));
+		REQUIRE_FALSE(tree.decompressContainer("format_damaged",
+				"format_decompressed.txt"));
+		REQUIRE_FALSE(tree.compressContainer("no_such_file.txt", "format_output",
+				options));
+
+	}
+
+}
+
+TEST_CASE("TESTING ARCHIVES:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+	string text = sampleText();
+
+	REQUIRE(tree.makeDirectories("archive_input/nested"));
+
+	writeTestFile("archive_input/a.txt", text);
+	writeTestFile("archive_input/b.txt", "");
+	writeTestFile("archive_input/nested/c.txt", text.substr(0, 3000) + text);
+	writeTestFile("archive_single.txt", text.substr(500, 700));
+
+	vector<string> paths = { "archive_input", "archive_single.txt" };
+	vector<string> names = { "a.txt", "b.txt", "nested/c.txt", "archive_single.txt" };
+
+	options.blockSize = 4096;
+
+	SECTION("Check the directory lists every member:") {
+
+		for (unsigned int jobs : { 1u, 3u }) {
+
+			vector<DPLKYL002::HuffmanTree::ArchiveMember> members;
+
+			REQUIRE(tree.createArchive(paths, "archive_output", options, jobs));
+			REQUIRE(tree.readArchiveDirectory("archive_output", members));
+			REQUIRE(members.size() == names.size());
+
+			for (size_t m = 0; m < members.size(); m++) {
+
+				REQUIRE(members[m].name == names[m]);
+				REQUIRE(members[m].tableId == 0);
+
+			}
+
+			REQUIRE(members[0].originalSize == text.size());
+			REQUIRE(members[1].originalSize == 0);
+			REQUIRE(members[1].offset == members[0].offset + members[0].compressedSize);
+
+		}
+
+	}
+
+	SECTION("Check single members are extracted:") {
+
+		REQUIRE(tree.createArchive(paths, "archive_output", options, 2));
+
+		for (const auto & name : names) {
+
+			DPLKYL002::HuffmanTree::bufferType output;
+			string fileName = name == "archive_single.txt" ? name : "archive_input/" + name;
+
+			REQUIRE(tree.extractMember("archive_output", name, output));
+			REQUIRE(string(output.begin(), output.end()) == readTestFile(fileName));
+
+		}
+
+		DPLKYL002::HuffmanTree::bufferType output;
+
+		REQUIRE_FALSE(tree.extractMember("archive_output", "missing.txt", output));
+
+		REQUIRE(tree.extractArchive("archive_output", "archive_extracted", { "nested/c.txt" }));
+		REQUIRE(readTestFile("archive_extracted/nested/c.txt")
+				== readTestFile("archive_input/nested/c.txt"));
+
+		REQUIRE(tree.extractArchive("archive_output", "archive_extracted", { }));
+		REQUIRE(readTestFile("archive_extracted/a.txt") == text);
+		REQUIRE(readTestFile("archive_extracted/archive_single.txt")
+				== text.substr(500, 700));
+
+	}
+
+	SECTION("Check files with the same member name are refused:") {
+
+		vector<DPLKYL002::HuffmanTree::ArchiveMember> members;
+
+		REQUIRE(tree.makeDirectories("archive_other"));
+		writeTestFile("archive_other/a.txt", "another a.txt");
+
+		REQUIRE_FALSE(tree.createArchive({ "archive_input/a.txt", "archive_other/a.txt" },
+				"archive_duplicate", options));
+		REQUIRE_FALSE(tree.createArchive({ "archive_input", "archive_other" },
+				"archive_duplicate", options, 2));
+		REQUIRE_FALSE(tree.readArchiveDirectory("archive_duplicate", members));
+
+	}
+
+	SECTION("Check damaged archives are refused:") {
+
+		REQUIRE(tree.createArchive(paths, "archive_output", options, 1));
+
+		string archive = readTestFile("archive_output");
+		vector<DPLKYL002::HuffmanTree::ArchiveMember> members;
+		DPLKYL002::HuffmanTree::bufferType output;
+
+		// a damaged member fails its CRC, while the others still extract
+		REQUIRE(tree.readArchiveDirectory("archive_output", members));
+
+		string damaged = archive;
+		damaged[members[0].offset + members[0].compressedSize - 6] ^= 0x10;
+		writeTestFile("archive_damaged", damaged);
+
+		REQUIRE_FALSE(tree.extractMember("archive_damaged", "a.txt", output));
+		REQUIRE(tree.extractMember("archive_damaged", "nested/c.txt", output));
+
+		// a cut off archive has no trailer
+		writeTestFile("archive_damaged", archive.substr(0, archive.size() - 1));
+
+		REQUIRE_FALSE(tree.readArchiveDirectory("archive_damaged", members));
+		REQUIRE_FALSE(tree.readArchiveDirectory("archive_single.txt", members));
+		REQUIRE_FALSE(tree.readArchiveDirectory("no_such_file.txt", members));
+
+	}
+
+}
+TEST_CASE("TESTING RANDOM-ACCESS DECOMPRESSION:") {
+
+	TestDirectory directory;
+	DPLKYL002::HuffmanTree tree;
+	DPLKYL002::HuffmanTree::Options options;
+	string text = sampleText();
+
+	writeTestFile("range_input.txt", text);
+
+	SECTION("Check ranges decoded from sync points match the input:") {
+
+		options.syncInterval = 100;
+		tree.compress("range_input.txt", "range_legacy", options);
+
+		REQUIRE(readTestFile("range_legacy.idx").substr(0, 4) == "DPLI");
+
+		vector<pair<unsigned long long, unsigned long long>> ranges = { { 0, 1 }, {
+				0, text.size() }, { 99, 2 }, { 100, 100 }, { 250, 1000 }, {
+				text.size() - 1, 1 }, { text.size() - 10, 500 }, { 1234, 0 }, {
+				text.size(), 5 }, { text.size() + 50, 5 } };
+
+		for (const auto & range : ranges) {
+
+			DPLKYL002::HuffmanTree::bufferType output;
+			string expected =
+					range.first < text.size() ? text.substr(range.first, range.second) : "";
+
+			REQUIRE(tree.decompressRange("range_legacy", range.first, range.second,
+					output));
+			REQUIRE(string(output.begin(), output.end()) == expected);
+
+		}
+
+		// every sync point, including one on the last letter
+		options.syncInterval = 1;
+		tree.compress("range_input.txt", "range_legacy", options);
+
+		for (unsigned long long offset = 0; offset < 300; offset += 37) {
+
+			DPLKYL002::HuffmanTree::bufferType output;
+
+			REQUIRE(tree.decompressRange("range_legacy", offset, 5, output));
+			REQUIRE(string(output.begin(), output.end()) == text.substr(offset, 5));
+
+		}
+
+	}
+
+	SECTION("Check files without an index are decompressed whole:") {
+
+		DPLKYL002::HuffmanTree::bufferType output;
+
+		// compressing again without sync points removes the old index
+		options.syncInterval = 64;
+		tree.compress("range_input.txt", "range_legacy", options);
+		options.syncInterval = 0;
+		tree.compress("range_input.txt", "range_legacy", options);
+
+		REQUIRE(readTestFile("range_legacy.idx") == "");
+		REQUIRE(tree.decompressRange("range_legacy", 300, 400, output));
+		REQUIRE(string(output.begin(), output.end()) == text.substr(300, 400));
+
+		options.blockSize = 4096;
+
+		REQUIRE(tree.compressContainer("range_input.txt", "range_container", options));
+		REQUIRE(tree.decompressRange("range_container", 5000, 123, output));
+		REQUIRE(string(output.begin(), output.end()) == text.substr(5000, 123));
+
+		REQUIRE_FALSE(tree.decompressRange("no_such_file.txt", 0, 10, output));
+
+	}
+
+	SECTION("Check container ranges decode only the blocks they overlap:") {
+
+		options.blockSize = 1000;
+
+		REQUIRE(tree.compressContainer("range_input.txt", "range_container", options));
+
+		vector<pair<unsigned long long, unsigned long long>> ranges = { { 0, 1 }, {
+				0, text.size() }, { 999, 2 }, { 1000, 1000 }, { 2500, 4000 }, {
+				text.size() - 1, 1 }, { text.size() - 10, 500 }, { 1234, 0 }, {
+				text.size(), 5 }, { text.size() + 50, 5 }, { 10, ~0ULL } };
+
+		for (const auto & range : ranges) {
+
+			DPLKYL002::HuffmanTree::bufferType output;
+			string expected =
+					range.first < text.size() ? text.substr(range.first, range.second) : "";
+
+			REQUIRE(tree.decompressRange("range_container", range.first, range.second,
+					output));
+			REQUIRE(string(output.begin(), output.end()) == expected);
+
+		}
+
+		// the payload of the first block is never read for a range after it
+		string container = readTestFile("range_container");
+		DPLKYL002::HuffmanTree::bufferType output;
+
+		writeTestFile("range_container",
+				container.substr(0, 21) + string(10, '\xFF') + container.substr(31));
+		REQUIRE(tree.decompressRange("range_container", 3000, 50, output));
+		REQUIRE(string(output.begin(), output.end()) == text.substr(3000, 50));
+
+		// a truncated container is refused
+		writeTestFile("range_container", container.substr(0, container.size() - 20));
+		REQUIRE_FALSE(tree.decompressRange("range_container", 0, text.size(), output));
+
+	}
+
+	SECTION("Check damaged indexes are refused:") {
+
+		DPLKYL002::HuffmanTree::bufferType output;
+
+		options.syncInterval = 100;
+		tree.compress("range_input.txt", "range_legacy", options);
+
+		string index = readTestFile("range_legacy.idx");
+
+		writeTestFile("range_legacy.idx", index.substr(0, index.size() - 3));
+		REQUIRE_FALSE(tree.decompressRange("range_legacy", 0, 10, output));
+
+		writeTestFile("range_legacy.idx", "DPLX" + index.substr(4));
+		REQUIRE_FALSE(tree.decompressRange("range_legacy", 0, 10, output));
+
+	}
+
+}
@@ -0,0 +1,192 @@
+//=======================================================================================
+// Name        : BitStream.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#ifndef LIBS_BITSTREAM_H
+#define LIBS_BITSTREAM_H
+
+#include <vector>
+#include <cstring>
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*Packs variable length codes into a byte buffer. Bits are written least significant
+  bit first (the DEFLATE bit order), so a code is stored bit reversed and a whole code
+  can be added to the bit buffer with a single shift.
+  */
+class BitWriter {
+
+private:
+	vector<unsigned char> & buffer;
+	size_t startSize; // size of the buffer when the writer was created
+	unsigned long long bitBuffer;
+	unsigned int bitCount;
+
+public:
+
+	BitWriter(vector<unsigned char> & b) :
+			buffer(b), startSize(b.size()), bitBuffer(0), bitCount(0) {
+
+	}
+
+	// write the numBits (at most 32) low bits of value
+	void writeBits(unsigned int value, unsigned int numBits) {
+
+		bitBuffer |= (unsigned long long) value << bitCount;
+		bitCount += numBits;
+
+		while (bitCount >= 8) {
+
+			buffer.push_back((unsigned char) bitBuffer);
+			bitBuffer >>= 8;
+			bitCount -= 8;
+
+		}
+
+	}
+
+	// pad the last partial byte with zero bits
+	void flush(void) {
+
+		if (bitCount > 0) {
+
+			writeBits(0, 8 - bitCount);
+
+		}
+
+	}
+
+	// number of bits written so far
+	unsigned long long getPosition(void) const {
+
+		return (unsigned long long) (buffer.size() - startSize) * 8 + bitCount;
+
+	}
+
+	/*For the encoder kernels, which write whole words straight into the buffer: hands
+	  over the bits not yet written (fewer than 8), to be passed back with writeBits.
+	  */
+	void takePendingBits(unsigned long long & bits, unsigned int & numBits) {
+
+		bits = bitBuffer;
+		numBits = bitCount;
+		bitBuffer = 0;
+		bitCount = 0;
+
+	}
+
+	vector<unsigned char> & getBuffer(void) {
+
+		return buffer;
+
+	}
+};
+
+// reads a bit stream produced by BitWriter, reading zero bits past the end of the data
+class BitReader {
+
+private:
+	const unsigned char * data;
+	size_t size;
+	unsigned long long position; // in bits
+
+public:
+
+	BitReader(const unsigned char * d, size_t s, unsigned long long start = 0) :
+			data(d), size(s), position(start) {
+
+	}
+
+	// look at the next numBits (at most 32) bits without consuming them
+	unsigned int peekBits(unsigned int numBits) const {
+
+		size_t byte = position >> 3;
+		unsigned long long window = 0;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		if (byte + 8 <= size) {
+
+			memcpy(&window, data + byte, 8);
+
+		} else
+#endif
+		{
+
+			for (size_t i = 0; i < 8 && byte + i < size; i++) {
+
+				window |= (unsigned long long) data[byte + i] << (8 * i);
+
+			}
+
+		}
+
+		return (unsigned int) ((window >> (position & 7))
+				& ((1ULL << numBits) - 1));
+
+	}
+
+	void skipBits(unsigned int numBits) {
+
+		position += numBits;
+
+	}
+
+	unsigned int readBits(unsigned int numBits) {
+
+		unsigned int value = peekBits(numBits);
+		position += numBits;
+
+		return value;
+
+	}
+
+	// skip to the start of the next byte
+	void alignToByte(void) {
+
+		position = (position + 7) & ~7ULL;
+
+	}
+
+	unsigned long long getPosition(void) const {
+
+		return position;
+
+	}
+
+	void setPosition(unsigned long long p) {
+
+		position = p;
+
+	}
+
+	// the underlying bytes, for the decoder kernels
+	const unsigned char * getData(void) const {
+
+		return data;
+
+	}
+
+	size_t getSize(void) const {
+
+		return size;
+
+	}
+
+	// true once more bits have been consumed than the data holds
+	bool overrun(void) const {
+
+		return position > (unsigned long long) size * 8;
+
+	}
+};
+
+}
+
+#endif
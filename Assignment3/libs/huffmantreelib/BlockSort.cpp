@@ -0,0 +1,369 @@
+//=======================================================================================
+// Name        : BlockSort.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "BlockSort.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+const unsigned int DPLKYL002::BlockSort::runA;
+const unsigned int DPLKYL002::BlockSort::runB;
+const unsigned int DPLKYL002::BlockSort::numSymbols;
+
+void DPLKYL002::BlockSort::buildSuffixArray(const unsigned char * data,
+		size_t size, vector<unsigned int> & suffixArray) {
+
+	/*Prefix doubling: after the pass for length k, suffixes are sorted by their first
+	  2k letters. A suffix's rank pair (rank of first k letters, rank of next k letters)
+	  is radix sorted - the second key order comes for free from the previous pass.
+	  Ranks start at 1, rank 0 stands for "past the end of the block".
+	  */
+	unsigned int n = size;
+	vector<unsigned int> rank(n), newRank(n), secondOrder(n), counts;
+
+	suffixArray.resize(n);
+
+	if (n == 0) {
+
+		return;
+
+	}
+
+	// first pass: sort by the first letter
+	counts.assign(257, 0);
+
+	for (unsigned int i = 0; i < n; i++) {
+
+		counts[data[i] + 1]++;
+
+	}
+
+	for (unsigned int c = 1; c < 257; c++) {
+
+		counts[c] += counts[c - 1];
+
+	}
+
+	for (unsigned int i = 0; i < n; i++) {
+
+		suffixArray[counts[data[i]]++] = i;
+
+	}
+
+	unsigned int numRanks = 0;
+
+	for (unsigned int j = 0; j < n; j++) {
+
+		if (j == 0 || data[suffixArray[j]] != data[suffixArray[j - 1]]) {
+
+			numRanks++;
+
+		}
+
+		rank[suffixArray[j]] = numRanks;
+
+	}
+
+	for (unsigned int k = 1; numRanks < n; k <<= 1) {
+
+		// order by the second key: suffixes with nothing after the first k letters first
+		unsigned int p = 0;
+
+		for (unsigned int i = n - min(k, n); i < n; i++) {
+
+			secondOrder[p++] = i;
+
+		}
+
+		for (unsigned int j = 0; j < n; j++) {
+
+			if (suffixArray[j] >= k) {
+
+				secondOrder[p++] = suffixArray[j] - k;
+
+			}
+
+		}
+
+		// stable counting sort by the first key
+		counts.assign(numRanks + 2, 0);
+
+		for (unsigned int i = 0; i < n; i++) {
+
+			counts[rank[i] + 1]++;
+
+		}
+
+		for (unsigned int r = 1; r < counts.size(); r++) {
+
+			counts[r] += counts[r - 1];
+
+		}
+
+		for (unsigned int j = 0; j < n; j++) {
+
+			unsigned int i = secondOrder[j];
+			suffixArray[counts[rank[i]]++] = i;
+
+		}
+
+		// re-rank by the (first, second) key pair
+		numRanks = 0;
+
+		for (unsigned int j = 0; j < n; j++) {
+
+			unsigned int i = suffixArray[j];
+			unsigned int second = i + k < n ? rank[i + k] : 0;
+
+			if (j == 0) {
+
+				numRanks = 1;
+
+			} else {
+
+				unsigned int previous = suffixArray[j - 1];
+				unsigned int previousSecond =
+						previous + k < n ? rank[previous + k] : 0;
+
+				if (rank[i] != rank[previous] || second != previousSecond) {
+
+					numRanks++;
+
+				}
+
+			}
+
+			newRank[i] = numRanks;
+
+		}
+
+		rank.swap(newRank);
+
+	}
+
+}
+
+unsigned int DPLKYL002::BlockSort::transform(const unsigned char * data,
+		size_t size, vector<unsigned char> & output) {
+
+	/*The sorted rotations of data + end marker are the sorted suffixes. The first row is
+	  the end marker itself, preceded by the last letter. The end marker is not output;
+	  its row (the primary index) is returned instead.
+	  */
+	vector<unsigned int> suffixArray;
+	buildSuffixArray(data, size, suffixArray);
+
+	output.clear();
+	output.reserve(size);
+
+	if (size == 0) {
+
+		return 0;
+
+	}
+
+	output.push_back(data[size - 1]);
+
+	unsigned int primaryIndex = 0;
+
+	for (unsigned int j = 0; j < size; j++) {
+
+		if (suffixArray[j] == 0) {
+
+			primaryIndex = j + 1;
+
+		} else {
+
+			output.push_back(data[suffixArray[j] - 1]);
+
+		}
+
+	}
+
+	return primaryIndex;
+
+}
+
+bool DPLKYL002::BlockSort::inverseTransform(const unsigned char * data,
+		size_t size, unsigned int primaryIndex, vector<unsigned char> & output) {
+
+	if (primaryIndex > size || (size > 0 && primaryIndex == 0)) {
+
+		return false;
+
+	}
+
+	output.resize(size);
+
+	if (size == 0) {
+
+		return true;
+
+	}
+
+	// the last column with the end marker put back at the primary index
+	unsigned int numRows = size + 1;
+	unsigned int counts[257] = { 0 };
+
+	auto letterAt = [&](unsigned int row) {
+
+		return row < primaryIndex ? data[row] : data[row - 1];
+
+	};
+
+	for (unsigned int row = 0; row < numRows; row++) {
+
+		if (row != primaryIndex) {
+
+			counts[letterAt(row) + 1]++;
+
+		}
+
+	}
+
+	// the end marker sorts first, so the letters start at row 1 of the first column
+	unsigned int first[257];
+	first[0] = 1;
+
+	for (unsigned int c = 1; c < 257; c++) {
+
+		first[c] = first[c - 1] + counts[c];
+
+	}
+
+	// LF mapping: the row of the rotation starting one letter earlier
+	vector<unsigned int> previousRow(numRows);
+
+	for (unsigned int row = 0; row < numRows; row++) {
+
+		if (row != primaryIndex) {
+
+			previousRow[row] = first[letterAt(row)]++;
+
+		}
+
+	}
+
+	// row 0 is the rotation starting with the end marker - walk backwards from it
+	unsigned int row = 0;
+
+	for (unsigned int i = size; i-- > 0;) {
+
+		if (row == primaryIndex) {
+
+			return false;
+
+		}
+
+		output[i] = letterAt(row);
+		row = previousRow[row];
+
+	}
+
+	return row == primaryIndex;
+
+}
+
+void DPLKYL002::BlockSort::moveToFront(const vector<unsigned char> & input,
+		vector<unsigned char> & output) {
+
+	unsigned char order[256];
+
+	for (unsigned int c = 0; c < 256; c++) {
+
+		order[c] = c;
+
+	}
+
+	output.resize(input.size());
+
+	for (size_t i = 0; i < input.size(); i++) {
+
+		unsigned char letter = input[i];
+		unsigned int index = 0;
+
+		while (order[index] != letter) {
+
+			index++;
+
+		}
+
+		memmove(order + 1, order, index);
+		order[0] = letter;
+		output[i] = index;
+
+	}
+
+}
+
+void DPLKYL002::BlockSort::inverseMoveToFront(
+		const vector<unsigned char> & input, vector<unsigned char> & output) {
+
+	unsigned char order[256];
+
+	for (unsigned int c = 0; c < 256; c++) {
+
+		order[c] = c;
+
+	}
+
+	output.resize(input.size());
+
+	for (size_t i = 0; i < input.size(); i++) {
+
+		unsigned int index = input[i];
+		unsigned char letter = order[index];
+
+		memmove(order + 1, order, index);
+		order[0] = letter;
+		output[i] = letter;
+
+	}
+
+}
+
+void DPLKYL002::BlockSort::encodeZeroRuns(const vector<unsigned char> & input,
+		vector<unsigned short> & symbols) {
+
+	/*A run of n zeros is written as n in bijective base 2, least significant digit
+	  first, with RUNA as digit 1 and RUNB as digit 2. Other values v become v + 1.
+	  */
+	symbols.clear();
+
+	for (size_t i = 0; i < input.size();) {
+
+		if (input[i] != 0) {
+
+			symbols.push_back(input[i] + 1);
+			i++;
+			continue;
+
+		}
+
+		size_t runEnd = i;
+
+		while (runEnd < input.size() && input[runEnd] == 0) {
+
+			runEnd++;
+
+		}
+
+		for (size_t run = runEnd - i; run > 0; run = (run - 1) >> 1) {
+
+			symbols.push_back((run & 1) ? runA : runB);
+
+		}
+
+		i = runEnd;
+
+	}
+
+}
@@ -0,0 +1,55 @@
+//=======================================================================================
+// Name        : BlockSort.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#ifndef LIBS_BLOCKSORT_H
+#define LIBS_BLOCKSORT_H
+
+#include <vector>
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*Block sorting front end (as in bzip2): the Burrows-Wheeler transform groups letters
+  that appear in similar contexts, move-to-front coding turns those groups into runs of
+  small numbers, and runs of zeros are replaced by RUNA / RUNB digits. The resulting
+  symbols are then coded by HuffmanTree.
+  */
+class BlockSort {
+
+public:
+
+	// symbols produced by encodeZeroRuns: RUNA, RUNB, then move-to-front value + 1
+	static const unsigned int runA = 0;
+	static const unsigned int runB = 1;
+	static const unsigned int numSymbols = 257;
+
+	// suffix array of data (prefix doubling with radix sort, O(n log n))
+	void buildSuffixArray(const unsigned char * data, size_t size,
+			vector<unsigned int> & suffixArray);
+
+	// returns the primary index - the row holding the end of string marker
+	unsigned int transform(const unsigned char * data, size_t size,
+			vector<unsigned char> & output);
+	bool inverseTransform(const unsigned char * data, size_t size,
+			unsigned int primaryIndex, vector<unsigned char> & output);
+
+	void moveToFront(const vector<unsigned char> & input,
+			vector<unsigned char> & output);
+	void inverseMoveToFront(const vector<unsigned char> & input,
+			vector<unsigned char> & output);
+
+	void encodeZeroRuns(const vector<unsigned char> & input,
+			vector<unsigned short> & symbols);
+
+};
+
+}
+
+#endif
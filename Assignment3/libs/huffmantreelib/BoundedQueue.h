@@ -0,0 +1,105 @@
+//=======================================================================================
+// Name        : BoundedQueue.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#ifndef LIBS_BOUNDEDQUEUE_H
+#define LIBS_BOUNDEDQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*A blocking queue of at most capacity items, used to hand blocks from one stage of the
+  compression pipeline to the next. push waits while the queue is full and pop while it
+  is empty. After close, pop drains what is left and then returns false.
+  */
+template<class T>
+class BoundedQueue {
+
+private:
+	mutex lock;
+	condition_variable notFull, notEmpty;
+	deque<T> items;
+	size_t capacity;
+	bool closed;
+
+public:
+
+	BoundedQueue(size_t c) :
+			capacity(c == 0 ? 1 : c), closed(false) {
+
+	}
+
+	// returns false (dropping the item) if the queue has been closed
+	bool push(T item) {
+
+		unique_lock<mutex> guard(lock);
+
+		notFull.wait(guard, [this]() {
+
+			return items.size() < capacity || closed;
+
+		});
+
+		if (closed) {
+
+			return false;
+
+		}
+
+		items.push_back(move(item));
+		notEmpty.notify_one();
+
+		return true;
+
+	}
+
+	// returns false once the queue is closed and empty
+	bool pop(T & item) {
+
+		unique_lock<mutex> guard(lock);
+
+		notEmpty.wait(guard, [this]() {
+
+			return !items.empty() || closed;
+
+		});
+
+		if (items.empty()) {
+
+			return false;
+
+		}
+
+		item = move(items.front());
+		items.pop_front();
+		notFull.notify_one();
+
+		return true;
+
+	}
+
+	// no more items will be pushed; wakes every waiting thread
+	void close(void) {
+
+		lock_guard<mutex> guard(lock);
+
+		closed = true;
+		notFull.notify_all();
+		notEmpty.notify_all();
+
+	}
+};
+
+}
+
+#endif
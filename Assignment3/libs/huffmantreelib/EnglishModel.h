@@ -0,0 +1,197 @@
+//=======================================================================================
+// Name        : EnglishModel.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#ifndef LIBS_ENGLISHMODEL_H
+#define LIBS_ENGLISHMODEL_H
+
+namespace DPLKYL002 {
+
+/*A built-in letter model for English text. The code lengths, canonical codes and the
+  decode table are all computed by the compiler (constexpr), so coding with the model
+  needs no first pass, no header and no table construction at run time.
+  */
+class EnglishModel {
+
+public:
+
+	// every code fits in one lookup of the decode table
+	static const unsigned int maxCodeLength = 12;
+
+	class Code {
+	public:
+
+		unsigned char codeLengths[256];
+		unsigned short codes[256]; // bit reversed, as written by BitWriter
+		unsigned short entries[1 << maxCodeLength]; // (symbol << 4) | code length
+
+	};
+
+	// approximate letter counts per 100000 letters of English prose (CRLF line ends)
+	static constexpr unsigned int frequency(unsigned int letter) {
+
+		return letter == ' ' ? 17000 : letter == 'e' ? 9400 : letter == 't' ? 6900 :
+				letter == 'a' ? 6100 : letter == 'o' ? 5900 : letter == 'i' ? 5300 :
+				letter == 'n' ? 5300 : letter == 's' ? 4900 : letter == 'h' ? 4900 :
+				letter == 'r' ? 4600 : letter == 'd' ? 3300 : letter == 'l' ? 3100 :
+				letter == 'u' ? 2200 : letter == 'c' ? 2100 : letter == 'm' ? 1900 :
+				letter == 'w' ? 1800 : letter == 'f' ? 1700 : letter == 'g' ? 1600 :
+				letter == 'y' ? 1600 : letter == 'p' ? 1400 : letter == 'b' ? 1100 :
+				letter == ',' ? 1200 : letter == '.' ? 1000 : letter == 'v' ? 780 :
+				letter == 'k' ? 620 : letter == '\r' ? 400 : letter == '\n' ? 400 :
+				letter == 'T' ? 400 : letter == 'I' ? 300 : letter == 'A' ? 250 :
+				letter == '\'' ? 250 : letter == '"' ? 250 : letter == 'S' ? 200 :
+				letter == '-' ? 200 : letter == 'H' ? 150 : letter == 'W' ? 150 :
+				letter == 'M' ? 130 : letter == 'B' ? 120 : letter == 'C' ? 120 :
+				letter == 'j' ? 120 : letter == 'x' ? 120 : letter == ';' ? 100 :
+				letter == '?' ? 80 : letter == '!' ? 80 : letter == 'q' ? 75 :
+				letter == 'z' ? 60 : letter == ':' ? 50 :
+				letter >= 'A' && letter <= 'Z' ? 70 :
+				letter >= '0' && letter <= '9' ? 50 :
+				letter > ' ' && letter < 127 ? 10 : 1;
+
+	}
+
+	// Huffman code lengths for the weights (O(n^2) merging - cheap enough for the compiler)
+	static constexpr unsigned int huffmanLengths(const unsigned long long * weights,
+			unsigned char * codeLengths) {
+
+		unsigned long long weight[511] = { };
+		unsigned int parent[511] = { };
+		bool active[511] = { };
+
+		for (unsigned int s = 0; s < 256; s++) {
+
+			weight[s] = weights[s];
+			active[s] = true;
+
+		}
+
+		for (unsigned int node = 256; node < 511; node++) {
+
+			unsigned int first = 511, second = 511;
+
+			for (unsigned int n = 0; n < node; n++) {
+
+				if (!active[n]) {
+
+					continue;
+
+				}
+
+				if (first == 511 || weight[n] < weight[first]) {
+
+					second = first;
+					first = n;
+
+				} else if (second == 511 || weight[n] < weight[second]) {
+
+					second = n;
+
+				}
+
+			}
+
+			weight[node] = weight[first] + weight[second];
+			parent[first] = parent[second] = node;
+			active[first] = active[second] = false;
+			active[node] = true;
+
+		}
+
+		unsigned int maxLength = 0;
+
+		for (unsigned int s = 0; s < 256; s++) {
+
+			unsigned int length = 0;
+
+			for (unsigned int n = s; n != 510; n = parent[n]) {
+
+				length++;
+
+			}
+
+			codeLengths[s] = length;
+			maxLength = length > maxLength ? length : maxLength;
+
+		}
+
+		return maxLength;
+
+	}
+
+	static constexpr Code buildCode(void) {
+
+		Code code = { };
+		unsigned long long weights[256] = { };
+
+		for (unsigned int s = 0; s < 256; s++) {
+
+			weights[s] = frequency(s);
+
+		}
+
+		// flatten the weights until every code fits (as buildCodeLengths does)
+		while (huffmanLengths(weights, code.codeLengths) > maxCodeLength) {
+
+			for (unsigned int s = 0; s < 256; s++) {
+
+				weights[s] = (weights[s] >> 1) | 1;
+
+			}
+
+		}
+
+		// canonical codes, shortest first, then in letter order
+		unsigned int nextCode = 0;
+
+		for (unsigned int length = 1; length <= maxCodeLength; length++) {
+
+			for (unsigned int s = 0; s < 256; s++) {
+
+				if (code.codeLengths[s] != length) {
+
+					continue;
+
+				}
+
+				unsigned int reversed = 0;
+
+				for (unsigned int bit = 0; bit < length; bit++) {
+
+					reversed |= ((nextCode >> bit) & 1) << (length - 1 - bit);
+
+				}
+
+				code.codes[s] = reversed;
+				nextCode++;
+
+				for (unsigned int fill = reversed; fill < (1u << maxCodeLength); fill +=
+						1u << length) {
+
+					code.entries[fill] = (s << 4) | length;
+
+				}
+
+			}
+
+			nextCode <<= 1;
+
+		}
+
+		return code;
+
+	}
+
+	static const Code code; // = buildCode(), evaluated by the compiler
+
+};
+
+}
+
+#endif
@@ -0,0 +1,769 @@
+//=======================================================================================
+// Name        : FileIO.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "FileIO.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define HUFFMAN_URING
+#endif
+#endif
+#endif
+
+using namespace std;
+
+const unsigned int DPLKYL002::FileIO::requestSize;
+const unsigned int DPLKYL002::FileIO::queueDepth;
+const unsigned int DPLKYL002::FileIO::directAlignment;
+const unsigned int DPLKYL002::FileIO::directBufferSize;
+const unsigned int DPLKYL002::FileIO::hugePageSize;
+
+namespace {
+
+// bytes [0, size) done with read / write, one request at a time
+long long transferSerially(int fd, unsigned char * data, size_t size,
+		unsigned long long offset, bool write) {
+
+	size_t done = 0;
+
+	while (done < size) {
+
+		size_t length = min(size - done, (size_t) DPLKYL002::FileIO::requestSize);
+		ssize_t result = write ?
+				pwrite(fd, data + done, length, offset + done) :
+				pread(fd, data + done, length, offset + done);
+
+		if (result < 0 && errno == EINTR) {
+
+			continue;
+
+		}
+
+		if (result < 0 || (result == 0 && write)) {
+
+			return -1;
+
+		}
+
+		if (result == 0) {
+
+			break; // the end of the file
+
+		}
+
+		done += result;
+
+	}
+
+	return done;
+
+}
+
+#ifdef HUFFMAN_URING
+
+/*An io_uring set up with the raw system calls (no liburing): the submission queue,
+  completion queue and submission entries are mapped from the kernel, and requests are
+  handed over by moving the ring indices.
+  */
+class Uring {
+public:
+
+	int fd;
+	unsigned int entries;
+
+	void * submissionRing;
+	size_t submissionRingSize;
+	void * completionRing;
+	size_t completionRingSize;
+	io_uring_sqe * submissions;
+
+	unsigned int * submissionHead;
+	unsigned int * submissionTail;
+	unsigned int * submissionMask;
+	unsigned int * submissionArray;
+	unsigned int * completionHead;
+	unsigned int * completionTail;
+	unsigned int * completionMask;
+	io_uring_cqe * completions;
+
+	Uring() :
+			fd(-1), entries(0), submissionRing(MAP_FAILED), submissionRingSize(0), completionRing(
+					MAP_FAILED), completionRingSize(0), submissions(
+					(io_uring_sqe *) MAP_FAILED) {
+
+	}
+
+	~Uring() {
+
+		if (submissions != MAP_FAILED) {
+
+			munmap(submissions, entries * sizeof(io_uring_sqe));
+
+		}
+
+		if (completionRing != MAP_FAILED) {
+
+			munmap(completionRing, completionRingSize);
+
+		}
+
+		if (submissionRing != MAP_FAILED) {
+
+			munmap(submissionRing, submissionRingSize);
+
+		}
+
+		if (fd >= 0) {
+
+			close(fd);
+
+		}
+
+	}
+
+	bool setup(unsigned int depth) {
+
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+
+		fd = syscall(__NR_io_uring_setup, depth, &params);
+
+		if (fd < 0) {
+
+			return false;
+
+		}
+
+		entries = params.sq_entries;
+		submissionRingSize = params.sq_off.array + entries * sizeof(unsigned int);
+		completionRingSize = params.cq_off.cqes
+				+ params.cq_entries * sizeof(io_uring_cqe);
+
+		submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		completionRing = mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		submissions = (io_uring_sqe *) mmap(nullptr, entries * sizeof(io_uring_sqe),
+				PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+				IORING_OFF_SQES);
+
+		if (submissionRing == MAP_FAILED || completionRing == MAP_FAILED
+				|| submissions == MAP_FAILED) {
+
+			return false;
+
+		}
+
+		char * sq = (char *) submissionRing;
+		char * cq = (char *) completionRing;
+
+		submissionHead = (unsigned int *) (sq + params.sq_off.head);
+		submissionTail = (unsigned int *) (sq + params.sq_off.tail);
+		submissionMask = (unsigned int *) (sq + params.sq_off.ring_mask);
+		submissionArray = (unsigned int *) (sq + params.sq_off.array);
+		completionHead = (unsigned int *) (cq + params.cq_off.head);
+		completionTail = (unsigned int *) (cq + params.cq_off.tail);
+		completionMask = (unsigned int *) (cq + params.cq_off.ring_mask);
+		completions = (io_uring_cqe *) (cq + params.cq_off.cqes);
+
+		return true;
+
+	}
+
+	// a cleared submission entry, or nullptr if the submission queue is full
+	io_uring_sqe * nextSubmission(void) {
+
+		unsigned int tail = *submissionTail;
+		unsigned int head = __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+
+		if (tail - head == entries) {
+
+			return nullptr;
+
+		}
+
+		unsigned int index = tail & *submissionMask;
+		io_uring_sqe * submission = &submissions[index];
+
+		memset(submission, 0, sizeof(*submission));
+		submissionArray[index] = index;
+
+		return submission;
+
+	}
+
+	// makes the entry from nextSubmission visible to the kernel
+	void queueSubmission(void) {
+
+		__atomic_store_n(submissionTail, *submissionTail + 1, __ATOMIC_RELEASE);
+
+	}
+
+	// submits the queued entries and waits for at least one completion
+	int enter(unsigned int toSubmit) {
+
+		int result;
+
+		do {
+
+			result = syscall(__NR_io_uring_enter, fd, toSubmit, 1,
+					IORING_ENTER_GETEVENTS, nullptr, 0);
+
+		} while (result < 0 && errno == EINTR);
+
+		return result;
+
+	}
+
+	bool nextCompletion(io_uring_cqe & completion) {
+
+		unsigned int head = *completionHead;
+
+		if (head == __atomic_load_n(completionTail, __ATOMIC_ACQUIRE)) {
+
+			return false;
+
+		}
+
+		completion = completions[head & *completionMask];
+		__atomic_store_n(completionHead, head + 1, __ATOMIC_RELEASE);
+
+		return true;
+
+	}
+
+	bool registerBuffer(unsigned char * data, size_t size) {
+
+		iovec buffer = { data, size };
+
+		return syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &buffer,
+				1) == 0;
+
+	}
+
+	void unregisterBuffers(void) {
+
+		syscall(__NR_io_uring_register, fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+
+	}
+};
+
+// one ring per thread, set up on first use (nullptr if io_uring can not be used)
+Uring * threadRing(void) {
+
+	thread_local unique_ptr<Uring> ring;
+	thread_local bool tried = false;
+
+	if (!tried) {
+
+		tried = true;
+		ring.reset(new Uring());
+
+		if (!ring->setup(DPLKYL002::FileIO::queueDepth)) {
+
+			ring.reset();
+
+		}
+
+	}
+
+	return ring.get();
+
+}
+
+// one requestSize piece of a transfer
+class Request {
+public:
+
+	size_t start, length, done;
+	bool finished;
+	iovec buffer; // for the vectored requests (no registered buffer)
+
+};
+
+/*Bytes [0, size) with up to queueDepth requests in flight. Short transfers are resumed
+  where they stopped; a read of 0 bytes is the end of the file.
+  */
+long long transferWithRing(Uring & ring, int fd, unsigned char * data, size_t size,
+		unsigned long long offset, bool write) {
+
+	size_t numRequests = (size + DPLKYL002::FileIO::requestSize - 1)
+			/ DPLKYL002::FileIO::requestSize;
+	vector<Request> requests(numRequests);
+
+	for (size_t r = 0; r < numRequests; r++) {
+
+		requests[r].start = r * DPLKYL002::FileIO::requestSize;
+		requests[r].length = min(size - requests[r].start,
+				(size_t) DPLKYL002::FileIO::requestSize);
+		requests[r].done = 0;
+		requests[r].finished = false;
+
+	}
+
+	// a registered buffer saves the kernel mapping the pages for every request
+	bool fixed = ring.registerBuffer(data, size);
+
+	auto queue = [&](size_t r) {
+
+		io_uring_sqe * submission = ring.nextSubmission();
+		Request & request = requests[r];
+		unsigned char * start = data + request.start + request.done;
+		size_t length = request.length - request.done;
+
+		if (fixed) {
+
+			submission->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+			submission->addr = (unsigned long long) start;
+			submission->len = length;
+			submission->buf_index = 0;
+
+		} else {
+
+			request.buffer.iov_base = start;
+			request.buffer.iov_len = length;
+			submission->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+			submission->addr = (unsigned long long) &request.buffer;
+			submission->len = 1;
+
+		}
+
+		submission->fd = fd;
+		submission->off = offset + request.start + request.done;
+		submission->user_data = r;
+		ring.queueSubmission();
+
+	};
+
+	size_t next = 0, inFlight = 0;
+	unsigned int toSubmit = 0;
+	bool failed = false;
+
+	while (!failed && (next < numRequests || inFlight > 0)) {
+
+		while (next < numRequests && inFlight < ring.entries) {
+
+			queue(next++);
+			inFlight++;
+			toSubmit++;
+
+		}
+
+		int submitted = ring.enter(toSubmit);
+
+		if (submitted < 0) {
+
+			failed = true;
+			break;
+
+		}
+
+		toSubmit -= min((unsigned int) submitted, toSubmit);
+
+		io_uring_cqe completion;
+
+		while (ring.nextCompletion(completion)) {
+
+			Request & request = requests[completion.user_data];
+			inFlight--;
+
+			if (completion.res == -EINTR || completion.res == -EAGAIN) {
+
+				queue(completion.user_data);
+				inFlight++;
+				toSubmit++;
+
+			} else if (completion.res < 0 || (completion.res == 0 && write)) {
+
+				failed = true;
+
+			} else if (completion.res == 0) {
+
+				request.finished = true; // the end of the file
+
+			} else {
+
+				request.done += completion.res;
+
+				if (request.done < request.length) {
+
+					queue(completion.user_data);
+					inFlight++;
+					toSubmit++;
+
+				} else {
+
+					request.finished = true;
+
+				}
+
+			}
+
+		}
+
+	}
+
+	// nothing may still be writing into the buffer when we return
+	while (failed && inFlight > 0) {
+
+		io_uring_cqe completion;
+
+		if (ring.enter(toSubmit) < 0) {
+
+			break;
+
+		}
+
+		toSubmit = 0;
+
+		while (ring.nextCompletion(completion)) {
+
+			inFlight--;
+
+		}
+
+	}
+
+	if (fixed) {
+
+		ring.unregisterBuffers();
+
+	}
+
+	if (failed) {
+
+		return -1;
+
+	}
+
+	// bytes up to the first short request (the end of the file)
+	long long transferred = 0;
+
+	for (const auto & request : requests) {
+
+		transferred += request.done;
+
+		if (request.done < request.length) {
+
+			break;
+
+		}
+
+	}
+
+	return transferred;
+
+}
+
+#endif
+
+}
+
+bool DPLKYL002::FileIO::uringSupported(void) {
+
+#ifdef HUFFMAN_URING
+	static const bool supported = []() {
+
+		Uring ring;
+		return ring.setup(1);
+
+	}();
+
+	return supported;
+#else
+	return false;
+#endif
+
+}
+
+int DPLKYL002::FileIO::openFile(string fileName, bool write, bool direct) {
+
+	int flags = write ? O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC : O_RDONLY | O_CLOEXEC;
+
+#ifdef O_DIRECT
+	if (direct) {
+
+		int fd = open(fileName.c_str(), flags | O_DIRECT, 0644);
+
+		// EINVAL: the file system (e.g. tmpfs) does not do direct I/O
+		if (fd >= 0 || errno != EINVAL) {
+
+			return fd;
+
+		}
+
+	}
+#endif
+
+	return open(fileName.c_str(), flags, 0644);
+
+}
+
+void DPLKYL002::FileIO::closeFile(int fd) {
+
+	if (fd >= 0) {
+
+		close(fd);
+
+	}
+
+}
+
+bool DPLKYL002::FileIO::fileSize(int fd, unsigned long long & size) {
+
+	struct stat status;
+
+	if (fstat(fd, &status) != 0) {
+
+		return false;
+
+	}
+
+	size = status.st_size;
+
+	return true;
+
+}
+
+long long DPLKYL002::FileIO::readAt(int fd, unsigned char * data, size_t size,
+		unsigned long long offset, Backend backend) {
+
+	return transfer(fd, data, size, offset, false, backend);
+
+}
+
+long long DPLKYL002::FileIO::writeAt(int fd, const unsigned char * data,
+		size_t size, unsigned long long offset, Backend backend) {
+
+	return transfer(fd, (unsigned char *) data, size, offset, true, backend);
+
+}
+
+long long DPLKYL002::FileIO::transfer(int fd, unsigned char * data, size_t size,
+		unsigned long long offset, bool write, Backend backend) {
+
+#ifdef HUFFMAN_URING
+	// a single request gains nothing from the ring
+	if (backend == BACKEND_URING && size > requestSize) {
+
+		Uring * ring = threadRing();
+
+		if (ring != nullptr) {
+
+			return transferWithRing(*ring, fd, data, size, offset, write);
+
+		}
+
+	}
+#endif
+
+	return transferSerially(fd, data, size, offset, write);
+
+}
+
+DPLKYL002::FileIO::AlignedBuffer::AlignedBuffer(size_t size, bool hugePages) :
+		buffer(nullptr), bufferSize(
+				(max(size, (size_t) 1) + directAlignment - 1) / directAlignment
+						* directAlignment), mappedSize(0) {
+
+	void * memory = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (hugePages) {
+
+		mappedSize = (bufferSize + hugePageSize - 1) / hugePageSize * hugePageSize;
+		memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+	}
+#endif
+
+	// no huge pages reserved: ordinary pages (mmap gives page aligned memory)
+	if (memory == MAP_FAILED) {
+
+		mappedSize = bufferSize;
+		memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+#ifdef MADV_HUGEPAGE
+		if (hugePages && memory != MAP_FAILED) {
+
+			madvise(memory, mappedSize, MADV_HUGEPAGE);
+
+		}
+#endif
+
+	}
+
+	if (memory == MAP_FAILED) {
+
+		throw bad_alloc();
+
+	}
+
+	buffer = (unsigned char *) memory;
+
+}
+
+DPLKYL002::FileIO::AlignedBuffer::~AlignedBuffer() {
+
+	munmap(buffer, mappedSize);
+
+}
+
+DPLKYL002::FileIO::DirectReader::DirectReader(int fd, Backend backend,
+		size_t bufferSize, bool hugePages) :
+		fd(fd), backend(backend), staging(bufferSize, hugePages), fileOffset(0), start(
+				0), end(0), endOfFile(false) {
+
+}
+
+long long DPLKYL002::FileIO::DirectReader::read(unsigned char * data,
+		size_t size) {
+
+	size_t done = 0;
+
+	while (done < size) {
+
+		if (start == end) {
+
+			if (endOfFile) {
+
+				break;
+
+			}
+
+			long long numRead = readAt(fd, staging.data(), staging.size(), fileOffset,
+					backend);
+
+			if (numRead < 0) {
+
+				return -1;
+
+			}
+
+			// only the end of the file stops a read short
+			endOfFile = (size_t) numRead < staging.size();
+			fileOffset += numRead;
+			start = 0;
+			end = numRead;
+
+			continue;
+
+		}
+
+		size_t length = min(size - done, end - start);
+
+		memcpy(data + done, staging.data() + start, length);
+		start += length;
+		done += length;
+
+	}
+
+	return done;
+
+}
+
+DPLKYL002::FileIO::DirectWriter::DirectWriter(int fd, Backend backend,
+		size_t bufferSize, bool hugePages) :
+		fd(fd), backend(backend), staging(bufferSize, hugePages), fileOffset(0), used(
+				0), failed(false) {
+
+}
+
+bool DPLKYL002::FileIO::DirectWriter::write(const unsigned char * data,
+		size_t size) {
+
+	while (size > 0 && !failed) {
+
+		size_t length = min(size, staging.size() - used);
+
+		memcpy(staging.data() + used, data, length);
+		used += length;
+		data += length;
+		size -= length;
+
+		if (used == staging.size()) {
+
+			flush(false);
+
+		}
+
+	}
+
+	return !failed;
+
+}
+
+bool DPLKYL002::FileIO::DirectWriter::finish(void) {
+
+	unsigned long long fileSize = fileOffset + used;
+
+	flush(true);
+
+	// the padding of the last block is cut off again
+	if (!failed && ftruncate(fd, fileSize) != 0) {
+
+		failed = true;
+
+	}
+
+	return !failed;
+
+}
+
+// writes the whole aligned blocks staged (and the padded last block when last is set)
+bool DPLKYL002::FileIO::DirectWriter::flush(bool last) {
+
+	size_t whole = last ?
+			(used + directAlignment - 1) / directAlignment * directAlignment :
+			used / directAlignment * directAlignment;
+
+	if (whole == 0 || failed) {
+
+		return !failed;
+
+	}
+
+	memset(staging.data() + used, 0, max(whole, used) - used);
+
+	if (writeAt(fd, staging.data(), whole, fileOffset, backend)
+			!= (long long) whole) {
+
+		failed = true;
+		return false;
+
+	}
+
+	// an unaligned tail waits for the next bytes
+	size_t tail = used - min(whole, used);
+
+	memmove(staging.data(), staging.data() + whole, tail);
+	fileOffset += whole;
+	used = tail;
+
+	return true;
+
+}
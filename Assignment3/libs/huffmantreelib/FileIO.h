@@ -0,0 +1,149 @@
+//=======================================================================================
+// Name        : FileIO.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#ifndef LIBS_FILEIO_H
+#define LIBS_FILEIO_H
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*File reads and writes at given offsets, for the I/O backends other than iostreams.
+  Large transfers are cut into requests of requestSize bytes. With io_uring up to
+  queueDepth requests are in flight at once (from a registered buffer when the kernel
+  allows it), so a fast device sees a deep queue; without io_uring the requests are
+  made one after another with pread / pwrite.
+  */
+class FileIO {
+
+public:
+
+	enum Backend {
+		BACKEND_STREAMS = 0, // ifstream / ofstream
+		BACKEND_PREAD = 1, // pread / pwrite
+		BACKEND_URING = 2 // io_uring, or pread / pwrite where it is not available
+	};
+
+	static const unsigned int requestSize = 1 << 18;
+	static const unsigned int queueDepth = 32;
+
+	// O_DIRECT transfers start, end and sit in memory on multiples of directAlignment
+	static const unsigned int directAlignment = 4096;
+	static const unsigned int directBufferSize = 1 << 23; // largest staging buffer
+	static const unsigned int hugePageSize = 1 << 21;
+
+	/*Memory for O_DIRECT transfers, page aligned. With hugePages it comes from reserved
+	  huge pages if there are any, else transparent huge pages are asked for.
+	  */
+	class AlignedBuffer {
+
+	private:
+		unsigned char * buffer;
+		size_t bufferSize, mappedSize;
+
+	public:
+
+		// size is rounded up to a multiple of directAlignment
+		AlignedBuffer(size_t size, bool hugePages = false);
+		~AlignedBuffer();
+
+		AlignedBuffer(const AlignedBuffer &) = delete;
+		AlignedBuffer & operator=(const AlignedBuffer &) = delete;
+
+		unsigned char * data(void) {
+
+			return buffer;
+
+		}
+
+		size_t size(void) const {
+
+			return bufferSize;
+
+		}
+	};
+
+	/*Reads a file from the start through an aligned staging buffer, so the file can be
+	  opened with O_DIRECT whatever the sizes asked for.
+	  */
+	class DirectReader {
+
+	private:
+		int fd;
+		Backend backend;
+		AlignedBuffer staging;
+		unsigned long long fileOffset; // of the end of the staged bytes
+		size_t start, end; // staged bytes not yet handed out
+		bool endOfFile;
+
+	public:
+
+		DirectReader(int fd, Backend backend, size_t bufferSize = directBufferSize,
+				bool hugePages = false);
+
+		// returns the number of bytes read (fewer than size at the end of the file), or -1
+		long long read(unsigned char * data, size_t size);
+	};
+
+	/*Writes a file from the start through an aligned staging buffer. Whole aligned blocks
+	  are written as the buffer fills; finish pads the last block and then cuts the file
+	  back to the bytes written.
+	  */
+	class DirectWriter {
+
+	private:
+		int fd;
+		Backend backend;
+		AlignedBuffer staging;
+		unsigned long long fileOffset; // of the start of the staged bytes
+		size_t used;
+		bool failed;
+
+		bool flush(bool last);
+
+	public:
+
+		DirectWriter(int fd, Backend backend, size_t bufferSize = directBufferSize,
+				bool hugePages = false);
+
+		bool write(const unsigned char * data, size_t size);
+		bool finish(void);
+	};
+
+	// true if this kernel (and its sandbox) lets us set up an io_uring
+	static bool uringSupported(void);
+
+	/*Returns -1 if the file can not be opened; files opened to write are created / emptied.
+	  direct asks for O_DIRECT (bypassing the page cache), which is dropped on file systems
+	  that do not support it.
+	  */
+	static int openFile(string fileName, bool write, bool direct = false);
+	static void closeFile(int fd);
+	static bool fileSize(int fd, unsigned long long & size);
+
+	/*Transfer size bytes at offset. Return the number of bytes transferred (fewer than
+	  size only when a read reaches the end of the file), or -1 on an error.
+	  */
+	static long long readAt(int fd, unsigned char * data, size_t size,
+			unsigned long long offset, Backend backend);
+	static long long writeAt(int fd, const unsigned char * data, size_t size,
+			unsigned long long offset, Backend backend);
+
+private:
+
+	static long long transfer(int fd, unsigned char * data, size_t size,
+			unsigned long long offset, bool write, Backend backend);
+};
+
+}
+
+#endif
@@ -0,0 +1,468 @@
+//=======================================================================================
+// Name        : HuffmanArchive.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+using namespace std;
+
+/*Archive layout: an 8 byte header (the magic bytes "DPLA", a version and three reserved
+  bytes), the members one after another (each a complete block container), the central
+  directory, then a 12 byte trailer holding the offset of the directory and "DPLA" again.
+  The directory holds the member count, then for each member: the name (2 byte length,
+  then the characters), its offset, compressed size and original size (8 bytes each), its
+  trained table ID and the CRC-32 of its original bytes (4 bytes each).
+  */
+namespace {
+
+const unsigned int archiveHeaderSize = 8, archiveTrailerSize = 12;
+
+// bytes [offset, offset + size) of an open file
+bool readRange(int fd, unsigned long long offset, size_t size,
+		DPLKYL002::HuffmanTree::bufferType & buffer,
+		DPLKYL002::FileIO::Backend backend) {
+
+	buffer.resize(size);
+
+	return DPLKYL002::FileIO::readAt(fd, buffer.data(), size, offset, backend)
+			== (long long) size;
+
+}
+
+// archive offsets are read with pread / io_uring (not iostreams, and not O_DIRECT)
+DPLKYL002::FileIO::Backend archiveBackend(
+		const DPLKYL002::HuffmanTree::Options & options) {
+
+	return options.backend == DPLKYL002::FileIO::BACKEND_URING ?
+			DPLKYL002::FileIO::BACKEND_URING : DPLKYL002::FileIO::BACKEND_PREAD;
+
+}
+
+// names are kept inside the output directory
+bool safeMemberName(const string & name) {
+
+	if (name.empty() || name[0] == '/') {
+
+		return false;
+
+	}
+
+	for (size_t start = 0; start <= name.size();) {
+
+		size_t end = min(name.find('/', start), name.size());
+
+		if (name.compare(start, end - start, "..") == 0 && end - start == 2) {
+
+			return false;
+
+		}
+
+		start = end + 1;
+
+	}
+
+	return true;
+
+}
+
+}
+
+/*Compresses every file under paths into one archive, jobs files at a time. The members
+  are written in the order the files are listed, a window of jobs files after another, so
+  only that many compressed files are held in memory. Two files with the same member name
+  (e.g. d1/x.txt and d2/x.txt, both named x.txt) are refused, and a partly written archive
+  is removed again.
+  */
+bool DPLKYL002::HuffmanTree::createArchive(const vector<string> & paths,
+		string archiveFileName, const Options & options, unsigned int jobs) {
+
+	vector<pair<string, string>> files;
+
+	for (const auto & path : paths) {
+
+		if (!listInputFiles(path, files)) {
+
+			return false;
+
+		}
+
+	}
+
+	set<string> names;
+
+	for (const auto & file : files) {
+
+		if (!names.insert(file.second).second) {
+
+			cout << "Duplicate member name: " << file.second << endl;
+			return false;
+
+		}
+
+	}
+
+	ofstream archiveFile(archiveFileName.c_str(), ios::binary);
+
+	if (!archiveFile.is_open()) {
+
+		cout << "Unable to open: " << archiveFileName << endl;
+		return false;
+
+	}
+
+	bufferType header;
+	const char magic[] = "DPLA";
+
+	header.insert(header.end(), magic, magic + 4);
+	header.push_back(1); // version
+	header.insert(header.end(), 3, 0);
+	archiveFile.write((const char *) header.data(), header.size());
+
+	jobs = max(1u, jobs);
+
+	Options memberOptions(options);
+	memberOptions.threads = max(1u, options.threads / jobs);
+
+	vector<ArchiveMember> members(files.size());
+	vector<bufferType> outputs(jobs);
+	unsigned long long offset = header.size();
+	atomic<size_t> numFailed(0);
+
+	for (size_t first = 0; first < files.size(); first += jobs) {
+
+		size_t windowSize = min((size_t) jobs, files.size() - first);
+
+		ThreadPool::shared().forEach(windowSize, [&](size_t w) {
+
+			HuffmanTree tree;
+			ArchiveMember & member = members[first + w];
+			bufferType input;
+
+			outputs[w].clear();
+
+			if (!tree.readFile(files[first + w].first, input, memberOptions)
+					|| !tree.compressBuffer(input, outputs[w], memberOptions)) {
+
+				numFailed++;
+				return;
+
+			}
+
+			member.name = files[first + w].second;
+			member.originalSize = input.size();
+			member.compressedSize = outputs[w].size();
+			member.crc = tree.crc32(input.data(), input.size());
+
+			// the table ID is read back from the container header
+			FrontEnd frontEnd;
+			size_t position = 0;
+			unsigned long long tableId = 0;
+
+			if (tree.readContainerHeader(outputs[w], position, frontEnd)
+					&& frontEnd == FRONT_END_TRAINED) {
+
+				tree.readInteger(outputs[w], position, 4, tableId);
+
+			}
+
+			member.tableId = tableId;
+
+		});
+
+		if (numFailed > 0) {
+
+			archiveFile.close();
+			remove(archiveFileName.c_str());
+			return false;
+
+		}
+
+		for (size_t w = 0; w < windowSize; w++) {
+
+			members[first + w].offset = offset;
+			archiveFile.write((const char *) outputs[w].data(), outputs[w].size());
+			offset += outputs[w].size();
+
+		}
+
+	}
+
+	bufferType directory;
+
+	appendInteger(directory, members.size(), 4);
+
+	for (const auto & member : members) {
+
+		appendInteger(directory, member.name.size(), 2);
+		directory.insert(directory.end(), member.name.begin(), member.name.end());
+		appendInteger(directory, member.offset, 8);
+		appendInteger(directory, member.compressedSize, 8);
+		appendInteger(directory, member.originalSize, 8);
+		appendInteger(directory, member.tableId, 4);
+		appendInteger(directory, member.crc, 4);
+
+	}
+
+	appendInteger(directory, offset, 8);
+	directory.insert(directory.end(), magic, magic + 4);
+
+	archiveFile.write((const char *) directory.data(), directory.size());
+	archiveFile.close();
+
+	if (!archiveFile) {
+
+		cout << "Unable to write: " << archiveFileName << endl;
+		remove(archiveFileName.c_str());
+		return false;
+
+	}
+
+	return true;
+
+}
+
+// reads the trailer and the central directory only
+bool DPLKYL002::HuffmanTree::readArchiveDirectory(string archiveFileName,
+		vector<ArchiveMember> & members) {
+
+	int fd = FileIO::openFile(archiveFileName, false);
+	unsigned long long fileSize;
+
+	if (fd < 0 || !FileIO::fileSize(fd, fileSize)) {
+
+		FileIO::closeFile(fd);
+		cout << "Unable to open: " << archiveFileName << endl;
+		return false;
+
+	}
+
+	bufferType header, trailer, directory;
+	unsigned long long directoryOffset = 0, value;
+	size_t position = 0;
+	bool valid = fileSize >= archiveHeaderSize + archiveTrailerSize
+			&& readRange(fd, 0, archiveHeaderSize, header, FileIO::BACKEND_PREAD)
+			&& string(header.begin(), header.begin() + 4) == "DPLA" && header[4] == 1
+			&& readRange(fd, fileSize - archiveTrailerSize, archiveTrailerSize, trailer,
+					FileIO::BACKEND_PREAD)
+			&& string(trailer.begin() + 8, trailer.end()) == "DPLA"
+			&& readInteger(trailer, position, 8, directoryOffset)
+			&& directoryOffset >= archiveHeaderSize
+			&& directoryOffset <= fileSize - archiveTrailerSize
+			&& readRange(fd, directoryOffset,
+					fileSize - archiveTrailerSize - directoryOffset, directory,
+					FileIO::BACKEND_PREAD);
+
+	FileIO::closeFile(fd);
+	members.clear();
+	position = 0;
+
+	if (!valid || !readInteger(directory, position, 4, value)) {
+
+		cout << "Not an archive: " << archiveFileName << endl;
+		return false;
+
+	}
+
+	for (unsigned long long m = 0; m < value; m++) {
+
+		ArchiveMember member;
+		unsigned long long nameLength, field;
+
+		if (!readInteger(directory, position, 2, nameLength)
+				|| position + nameLength > directory.size()) {
+
+			valid = false;
+			break;
+
+		}
+
+		member.name = string(directory.begin() + position,
+				directory.begin() + position + nameLength);
+		position += nameLength;
+
+		valid = readInteger(directory, position, 8, member.offset)
+				&& readInteger(directory, position, 8, member.compressedSize)
+				&& readInteger(directory, position, 8, member.originalSize)
+				&& readInteger(directory, position, 4, field);
+		member.tableId = field;
+		valid = valid && readInteger(directory, position, 4, field);
+		member.crc = field;
+
+		// every member lies between the header and the directory
+		if (!valid || member.offset < archiveHeaderSize
+				|| member.compressedSize > directoryOffset
+				|| member.offset > directoryOffset - member.compressedSize) {
+
+			valid = false;
+			break;
+
+		}
+
+		members.push_back(member);
+
+	}
+
+	if (!valid) {
+
+		cout << "Corrupt archive directory: " << archiveFileName << endl;
+		return false;
+
+	}
+
+	return true;
+
+}
+
+// reads and decodes one member, and checks it against the CRC in the directory
+bool DPLKYL002::HuffmanTree::decodeMember(int fd, const ArchiveMember & member,
+		bufferType & output, const Options & options) {
+
+	bufferType input;
+
+	output.clear();
+
+	return readRange(fd, member.offset, member.compressedSize, input,
+			archiveBackend(options)) && decompressBuffer(input, output, options)
+			&& output.size() == member.originalSize
+			&& crc32(output.data(), output.size()) == member.crc;
+
+}
+
+// reads the directory and the one member, nothing else
+bool DPLKYL002::HuffmanTree::extractMember(string archiveFileName,
+		string memberName, bufferType & output, const Options & options) {
+
+	vector<ArchiveMember> members;
+
+	if (!readArchiveDirectory(archiveFileName, members)) {
+
+		return false;
+
+	}
+
+	auto member = find_if(members.begin(), members.end(),
+			[&](const ArchiveMember & member) {
+
+				return member.name == memberName;
+
+			});
+
+	if (member == members.end()) {
+
+		cout << "No member " << memberName << " in " << archiveFileName << endl;
+		return false;
+
+	}
+
+	int fd = FileIO::openFile(archiveFileName, false);
+	bool decoded = fd >= 0 && decodeMember(fd, *member, output, options);
+
+	FileIO::closeFile(fd);
+
+	if (!decoded) {
+
+		cout << "Corrupt archive member: " << memberName << endl;
+		return false;
+
+	}
+
+	return true;
+
+}
+
+// extracts the members named (every member if memberNames is empty) below outputDirectory
+bool DPLKYL002::HuffmanTree::extractArchive(string archiveFileName,
+		string outputDirectory, const vector<string> & memberNames,
+		const Options & options) {
+
+	vector<ArchiveMember> members;
+
+	if (!readArchiveDirectory(archiveFileName, members)) {
+
+		return false;
+
+	}
+
+	for (const auto & name : memberNames) {
+
+		if (none_of(members.begin(), members.end(),
+				[&](const ArchiveMember & member) {
+
+					return member.name == name;
+
+				})) {
+
+			cout << "No member " << name << " in " << archiveFileName << endl;
+			return false;
+
+		}
+
+	}
+
+	int fd = FileIO::openFile(archiveFileName, false);
+
+	if (fd < 0) {
+
+		cout << "Unable to open: " << archiveFileName << endl;
+		return false;
+
+	}
+
+	bool extracted = true;
+
+	for (const auto & member : members) {
+
+		if (!memberNames.empty()
+				&& find(memberNames.begin(), memberNames.end(), member.name)
+						== memberNames.end()) {
+
+			continue;
+
+		}
+
+		string outputFileName = outputDirectory + "/" + member.name;
+		bufferType output;
+
+		if (!safeMemberName(member.name)) {
+
+			cout << "Unsafe member name: " << member.name << endl;
+			extracted = false;
+			continue;
+
+		}
+
+		if (!decodeMember(fd, member, output, options)) {
+
+			cout << "Corrupt archive member: " << member.name << endl;
+			extracted = false;
+			continue;
+
+		}
+
+		if (!makeDirectories(outputFileName.substr(0, outputFileName.find_last_of('/')))
+				|| !writeFile(outputFileName, output, options)) {
+
+			extracted = false;
+
+		}
+
+	}
+
+	FileIO::closeFile(fd);
+
+	return extracted;
+
+}
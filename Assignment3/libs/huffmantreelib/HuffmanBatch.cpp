@@ -0,0 +1,247 @@
+//=======================================================================================
+// Name        : HuffmanBatch.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+const unsigned int DPLKYL002::HuffmanTree::batchThreshold;
+
+namespace {
+
+// splits records [0, numRecords) into ranges of about the same number of bytes
+void splitRecords(const vector<DPLKYL002::HuffmanTree::Span> & records,
+		size_t numRanges, vector<size_t> & rangeStarts) {
+
+	unsigned long long totalSize = 0, size = 0;
+
+	for (const auto & record : records) {
+
+		totalSize += record.size;
+
+	}
+
+	rangeStarts.assign(1, 0);
+
+	for (size_t r = 0; r < records.size() && rangeStarts.size() < numRanges;
+			r++) {
+
+		size += records[r].size;
+
+		if (size * numRanges >= totalSize * rangeStarts.size()) {
+
+			rangeStarts.push_back(r + 1);
+
+		}
+
+	}
+
+	rangeStarts.push_back(records.size());
+
+}
+
+// runs work(range) for every record range, as tasks of the library's thread pool
+template<class Work>
+void forEachRange(const vector<size_t> & rangeStarts, Work work) {
+
+	DPLKYL002::ThreadPool::shared().forEach(rangeStarts.size() - 1, work);
+
+}
+
+}
+
+/*Compresses many short independent records with one code built from the letters of the
+  whole batch. The code lengths are written once to header; each output record is its
+  letter count (a varint) followed by its codes. Codes are at most DecodeTable::lookupBits
+  long, so every letter decodes with a single table lookup.
+  */
+void DPLKYL002::HuffmanTree::compressBatch(const vector<Span> & inputs,
+		bufferType & header, vector<bufferType> & outputs,
+		const Options & options) {
+
+	unsigned long long totalSize = 0;
+
+	for (const auto & input : inputs) {
+
+		totalSize += input.size;
+
+	}
+
+	size_t numThreads = totalSize < batchThreshold ? 1 : max(1u, options.threads);
+	vector<size_t> rangeStarts;
+
+	splitRecords(inputs, numThreads, rangeStarts);
+
+	// one histogram per range, then combined
+	vector<vector<unsigned long long>> rangeFrequencies(rangeStarts.size() - 1,
+			vector<unsigned long long>(256, 0));
+
+	forEachRange(rangeStarts, [&](size_t range) {
+
+		vector<unsigned long long> & frequencies = rangeFrequencies[range];
+
+		for (size_t r = rangeStarts[range]; r < rangeStarts[range + 1]; r++) {
+
+			for (size_t i = 0; i < inputs[r].size; i++) {
+
+				frequencies[inputs[r].data[i]]++;
+
+			}
+
+		}
+
+	});
+
+	vector<unsigned long long> totals(256, 0);
+
+	for (const auto & frequencies : rangeFrequencies) {
+
+		for (unsigned int c = 0; c < 256; c++) {
+
+			totals[c] += frequencies[c];
+
+		}
+
+	}
+
+	// scale very large batches down to the counts buildCodeLengths takes
+	unsigned int shift = 0;
+
+	while ((*max_element(totals.begin(), totals.end()) >> shift) > 0x7FFFFFFF) {
+
+		shift++;
+
+	}
+
+	vector<unsigned int> frequencies(256, 0);
+
+	for (unsigned int c = 0; c < 256; c++) {
+
+		frequencies[c] = totals[c] == 0 ? 0 : max(1ull, totals[c] >> shift);
+
+	}
+
+	vector<unsigned char> codeLengths;
+	vector<unsigned int> codes;
+
+	vector<unsigned int> packedCodes;
+
+	buildCodeLengths(frequencies, codeLengths, DecodeTable::lookupBits);
+	buildCanonicalCodes(codeLengths, codes);
+	packCodes(codes, codeLengths, packedCodes);
+
+	header.clear();
+
+	BitWriter headerWriter(header);
+	writeCodeLengths(headerWriter, codeLengths);
+	headerWriter.flush();
+
+	outputs.resize(inputs.size());
+
+	forEachRange(rangeStarts, [&](size_t range) {
+
+		HuffmanTree tree;
+
+		for (size_t r = rangeStarts[range]; r < rangeStarts[range + 1]; r++) {
+
+			const Span & input = inputs[r];
+			bufferType & output = outputs[r];
+
+			// allocated once: the letter count and the room encodeSymbols asks for
+			output.clear();
+			output.reserve(10 + input.size * 2 + 16);
+
+			tree.appendVarint(output, input.size);
+
+			BitWriter writer(output);
+			tree.encodeSymbols(input.data, input.size, packedCodes.data(), writer);
+			writer.flush();
+
+		}
+
+	});
+
+}
+
+bool DPLKYL002::HuffmanTree::decompressBatch(const bufferType & header,
+		const vector<Span> & inputs, vector<bufferType> & outputs,
+		const Options & options) {
+
+	BitReader headerReader(header.data(), header.size());
+	vector<unsigned char> codeLengths;
+	shared_ptr<const DecodeTable> table;
+
+	if (!readCodeLengths(headerReader, codeLengths) || codeLengths.size() > 256
+			|| !(table = findDecodeTable(codeLengths))) {
+
+		return false;
+
+	}
+
+	unsigned long long totalSize = 0;
+
+	for (const auto & input : inputs) {
+
+		totalSize += input.size;
+
+	}
+
+	size_t numThreads = totalSize < batchThreshold ? 1 : max(1u, options.threads);
+	vector<size_t> rangeStarts;
+	atomic<bool> valid(true);
+
+	splitRecords(inputs, numThreads, rangeStarts);
+	outputs.resize(inputs.size());
+
+	forEachRange(rangeStarts, [&](size_t range) {
+
+		HuffmanTree tree;
+
+		if (!tree.decodeRecords(*table, inputs, outputs, rangeStarts[range],
+				rangeStarts[range + 1])) {
+
+			valid = false;
+
+		}
+
+	});
+
+	return valid;
+
+}
+
+// one batch record: the letter count, then the codes
+bool DPLKYL002::HuffmanTree::decodeRecord(const DecodeTable & table,
+		const unsigned char * data, size_t size, bufferType & output) {
+
+	size_t position = 0;
+	unsigned long long rawSize;
+
+	// every letter takes at least one bit
+	if (!readVarint(data, size, position, rawSize)
+			|| rawSize > (size - position) * 8) {
+
+		return false;
+
+	}
+
+	BitReader reader(data + position, size - position);
+
+	size_t outputStart = output.size();
+	output.resize(outputStart + rawSize);
+
+	decodeSymbols(table, reader, output.data() + outputStart, rawSize);
+
+	return !reader.overrun();
+
+}
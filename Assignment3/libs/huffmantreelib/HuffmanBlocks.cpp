@@ -0,0 +1,1117 @@
+//=======================================================================================
+// Name        : HuffmanBlocks.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+#include "BlockSort.h"
+#include "ThreadPool.h"
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+/*Block container layout: the container header, the block size, then one record per
+  block (raw size, payload size, block type and payload) and finally a raw size of 0.
+  Every block has its own code table, so blocks can be decoded independently. With a
+  trained table the table ID follows the container header and the blocks carry no table.
+  */
+bool DPLKYL002::HuffmanTree::compressContainer(string inputFileName,
+		string outputFileName, const Options & options) {
+
+	// fixed size blocks can be read, encoded and written a few at a time
+	if (options.frontEnd != FRONT_END_WORDS && !options.splitBlocks) {
+
+		return compressStream(inputFileName, outputFileName, options);
+
+	}
+
+	bufferType input, output;
+
+	if (!readFile(inputFileName, input, options)) {
+
+		return false;
+
+	}
+
+	if (!compressBuffer(input, output, options)) {
+
+		return false;
+
+	}
+
+	return writeFile(outputFileName, output, options);
+
+}
+
+bool DPLKYL002::HuffmanTree::decompressContainer(string inputFileName,
+		string outputFileName, const Options & options) {
+
+	bufferType input, output;
+
+	if (!readFile(inputFileName, input, options)) {
+
+		return false;
+
+	}
+
+	if (!decompressBuffer(input, output, options)) {
+
+		cout << "Corrupt compressed file: " << inputFileName << endl;
+		return false;
+
+	}
+
+	return writeFile(outputFileName, output, options);
+
+}
+
+bool DPLKYL002::HuffmanTree::compressBuffer(const bufferType & input,
+		bufferType & output, const Options & options) {
+
+	Options blockOptions(options);
+	StaticTable staticTable;
+
+	// a trained table which can not be loaded fails the input (nothing is written)
+	if (options.frontEnd == FRONT_END_TRAINED
+			&& !loadTable(options.tableDirectory, options.tableId, staticTable)) {
+
+		cout << "Unable to load table: "
+				<< tableFileName(options.tableDirectory, options.tableId) << endl;
+		return false;
+
+	}
+
+	appendContainerHeader(output, blockOptions.frontEnd);
+
+	// the word dictionary is built over the whole input, so it is not split into blocks
+	if (blockOptions.frontEnd == FRONT_END_WORDS) {
+
+		encodeWords(input, output);
+		return true;
+
+	}
+
+	if (blockOptions.frontEnd == FRONT_END_TRAINED) {
+
+		appendInteger(output, staticTable.id, 4);
+
+	}
+
+	size_t blockSize = max(1u, blockOptions.blockSize);
+	vector<size_t> blockStarts;
+
+	chooseBlockSplits(input.data(), input.size(), blockOptions, blockStarts);
+
+	size_t numBlocks = blockStarts.size() - 1;
+	size_t numThreads = min((size_t) max(1u, blockOptions.threads), numBlocks);
+
+	appendInteger(output, blockSize, 4);
+
+	if (numThreads <= 1) {
+
+		// one block at a time, each split over all the threads
+		for (size_t b = 0; b < numBlocks; b++) {
+
+			encodeBlock(input.data() + blockStarts[b],
+					blockStarts[b + 1] - blockStarts[b], blockOptions, output,
+					&staticTable);
+
+		}
+
+	} else {
+
+		// blocks are independent, so each task takes the next block still to be encoded
+		vector<bufferType> blockOutputs(numBlocks);
+		atomic<size_t> nextBlock(0);
+
+		// threads left over when there are fewer blocks than threads split the blocks
+		Options workerOptions(blockOptions);
+		workerOptions.threads = max(1u, blockOptions.threads / (unsigned int) numThreads);
+
+		ThreadPool::shared().forEach(numThreads, [&](size_t) {
+
+			HuffmanTree tree;
+
+			for (size_t b = nextBlock++; b < numBlocks; b = nextBlock++) {
+
+				tree.encodeBlock(input.data() + blockStarts[b],
+						blockStarts[b + 1] - blockStarts[b], workerOptions,
+						blockOutputs[b], &staticTable);
+
+			}
+
+		});
+
+		for (const auto & blockOutput : blockOutputs) {
+
+			output.insert(output.end(), blockOutput.begin(), blockOutput.end());
+
+		}
+
+	}
+
+	appendInteger(output, 0, 4); // end of blocks
+
+	return true;
+
+}
+
+bool DPLKYL002::HuffmanTree::decompressBuffer(const bufferType & input,
+		bufferType & output, const Options & options) {
+
+	size_t position = 0;
+	FrontEnd frontEnd;
+	unsigned long long blockSize, tableId;
+	StaticTable staticTable;
+
+	if (!readContainerHeader(input, position, frontEnd)) {
+
+		return false;
+
+	}
+
+	if (frontEnd == FRONT_END_WORDS) {
+
+		return decodeWords(input, position, output);
+
+	}
+
+	if (frontEnd == FRONT_END_TRAINED
+			&& (!readInteger(input, position, 4, tableId)
+					|| !loadTable(options.tableDirectory, tableId, staticTable))) {
+
+		return false;
+
+	}
+
+	if (!readInteger(input, position, 4, blockSize)) {
+
+		return false;
+
+	}
+
+	while (true) {
+
+		size_t rawSize, payloadSize;
+		BlockType blockType;
+
+		if (!readBlockHeader(input, position, rawSize, payloadSize, blockType)) {
+
+			return false;
+
+		}
+
+		if (rawSize == 0) {
+
+			return true;
+
+		}
+
+		if (!decodeBlock(input.data() + position, payloadSize, blockType,
+				frontEnd, rawSize, output, &staticTable)) {
+
+			return false;
+
+		}
+
+		position += payloadSize;
+
+	}
+
+}
+
+void DPLKYL002::HuffmanTree::encodeBlock(const unsigned char * data,
+		size_t size, const Options & options, bufferType & output,
+		const StaticTable * staticTable) {
+
+	size_t recordStart = output.size();
+
+	appendInteger(output, size, 4);
+	appendInteger(output, 0, 4); // payload size, filled in below
+
+	// a trained table codes every letter, so there is no frequency pass
+	BlockType blockType = BLOCK_STATIC;
+	vector<unsigned char> codeLengths;
+
+	if (options.frontEnd != FRONT_END_TRAINED) {
+
+		vector<unsigned int> frequencies(256, 0);
+
+		for (size_t i = 0; i < size; i++) {
+
+			frequencies[data[i]]++;
+
+		}
+
+		// the order-0 code lengths built to choose the block type are reused to code it
+		blockType = chooseBlockType(frequencies, size, options.frontEnd, &codeLengths);
+
+	}
+
+	output.push_back(blockType);
+
+	if (blockType == BLOCK_SINGLE) {
+
+		output.push_back(data[0]);
+
+	} else if (blockType == BLOCK_STORED) {
+
+		output.insert(output.end(), data, data + size);
+
+	} else {
+
+		switch (options.frontEnd) {
+
+		case FRONT_END_RLE:
+			encodeRunLengths(data, size, output);
+			break;
+
+		case FRONT_END_BWT:
+			encodeBlockSorted(data, size, output);
+			break;
+
+		case FRONT_END_LZ77:
+			encodeLZ77(data, size, options.level, output);
+			break;
+
+		case FRONT_END_TRAINED:
+			encodeStatic(data, size, *staticTable, output, options.threads);
+			break;
+
+		default:
+			encodeBytes(data, size, output, options.threads, &codeLengths);
+			break;
+
+		}
+
+		// never expand a block: fall back to storing it
+		if (output.size() - recordStart - 9 >= size) {
+
+			output.resize(recordStart + 8);
+			output.push_back(BLOCK_STORED);
+			output.insert(output.end(), data, data + size);
+
+		}
+
+	}
+
+	size_t payloadSize = output.size() - recordStart - 9;
+
+	for (unsigned int i = 0; i < 4; i++) {
+
+		output[recordStart + 4 + i] = (unsigned char) (payloadSize >> (8 * i));
+
+	}
+
+}
+
+/*Exact size of the container compressBuffer would produce for the order-0 front end
+  with these block settings, computed from the block histograms and code lengths alone
+  (no codes are built and nothing is written).
+  */
+unsigned long long DPLKYL002::HuffmanTree::estimateCompressedSize(
+		const bufferType & input, const Options & options) {
+
+	Options bytesOptions(options);
+	bytesOptions.frontEnd = FRONT_END_BYTES;
+
+	vector<size_t> blockStarts;
+	chooseBlockSplits(input.data(), input.size(), bytesOptions, blockStarts);
+
+	// container header, block size and end of blocks marker
+	unsigned long long size = 8 + 4 + 4;
+	vector<unsigned int> frequencies(256);
+
+	for (size_t b = 0; b + 1 < blockStarts.size(); b++) {
+
+		size_t blockSize = blockStarts[b + 1] - blockStarts[b];
+
+		fill(frequencies.begin(), frequencies.end(), 0);
+
+		for (size_t i = blockStarts[b]; i < blockStarts[b + 1]; i++) {
+
+			frequencies[input[i]]++;
+
+		}
+
+		size += 9; // block record
+
+		switch (chooseBlockType(frequencies, blockSize, FRONT_END_BYTES)) {
+
+		case BLOCK_SINGLE:
+			size += 1;
+			break;
+
+		case BLOCK_STORED:
+			size += blockSize;
+			break;
+
+		default:
+			size += (estimateHuffmanBits(frequencies) - 9 * 8 + 7) / 8;
+			break;
+
+		}
+
+	}
+
+	return size;
+
+}
+
+/*Block boundaries (as offsets, ending with size). Blocks are options.blockSize long,
+  unless adaptive splitting is on: the input is then scanned in segments, and a segment
+  starts a new block when coding it with its own table (header included) is cheaper than
+  adding it to the current block's table.
+  */
+void DPLKYL002::HuffmanTree::chooseBlockSplits(const unsigned char * data,
+		size_t size, const Options & options, vector<size_t> & blockStarts) {
+
+	size_t blockSize = max(1u, options.blockSize);
+
+	blockStarts.clear();
+
+	bool adaptive = options.splitBlocks
+			&& (options.frontEnd == FRONT_END_BYTES
+					|| options.frontEnd == FRONT_END_RLE);
+
+	if (!adaptive) {
+
+		for (size_t offset = 0; offset < size; offset += blockSize) {
+
+			blockStarts.push_back(offset);
+
+		}
+
+		blockStarts.push_back(size);
+		return;
+
+	}
+
+	const size_t segmentSize = min((size_t) 16384, blockSize);
+
+	vector<unsigned int> blockFrequencies(256, 0), segmentFrequencies(256),
+			mergedFrequencies(256);
+	unsigned long long blockCost = 0;
+	size_t blockStart = 0;
+
+	blockStarts.push_back(0);
+
+	for (size_t offset = 0; offset < size; offset += segmentSize) {
+
+		size_t segmentEnd = min(offset + segmentSize, size);
+
+		fill(segmentFrequencies.begin(), segmentFrequencies.end(), 0);
+
+		for (size_t i = offset; i < segmentEnd; i++) {
+
+			segmentFrequencies[data[i]]++;
+
+		}
+
+		if (offset == blockStart) {
+
+			blockFrequencies = segmentFrequencies;
+			blockCost = estimateHuffmanBits(blockFrequencies);
+			continue;
+
+		}
+
+		for (unsigned int c = 0; c < 256; c++) {
+
+			mergedFrequencies[c] = blockFrequencies[c] + segmentFrequencies[c];
+
+		}
+
+		unsigned long long mergedCost = estimateHuffmanBits(mergedFrequencies);
+		unsigned long long segmentCost = estimateHuffmanBits(segmentFrequencies);
+
+		if (blockCost + segmentCost < mergedCost
+				|| segmentEnd - blockStart > blockSize) {
+
+			// the statistics drifted (or the block is full): start a new block here
+			blockStarts.push_back(offset);
+			blockStart = offset;
+			blockFrequencies = segmentFrequencies;
+			blockCost = segmentCost;
+
+		} else {
+
+			blockFrequencies = mergedFrequencies;
+			blockCost = mergedCost;
+
+		}
+
+	}
+
+	if (size == 0) {
+
+		blockStarts.clear();
+
+	}
+
+	blockStarts.push_back(size);
+
+}
+
+// size in bits of an order-0 Huffman coded block with these frequencies, header included
+unsigned long long DPLKYL002::HuffmanTree::estimateHuffmanBits(
+		const vector<unsigned int> & frequencies) {
+
+	vector<unsigned char> codeLengths;
+
+	return estimateHuffmanBits(frequencies, codeLengths);
+
+}
+
+// as above, keeping the code lengths the estimate was made from
+unsigned long long DPLKYL002::HuffmanTree::estimateHuffmanBits(
+		const vector<unsigned int> & frequencies,
+		vector<unsigned char> & codeLengths) {
+
+	buildCodeLengths(frequencies, codeLengths);
+
+	unsigned int numSymbols = codeLengths.size();
+
+	while (numSymbols > 0 && codeLengths[numSymbols - 1] == 0) {
+
+		numSymbols--;
+
+	}
+
+	// block record, code length header, then the codes
+	unsigned long long bits = 9 * 8 + 24 + 4 * numSymbols;
+
+	for (unsigned int s = 0; s < frequencies.size(); s++) {
+
+		bits += (unsigned long long) frequencies[s] * codeLengths[s];
+
+	}
+
+	return bits;
+
+}
+
+/*Chooses how a block is coded from its letter histogram, before encoding it: a single
+  repeated letter is stored as that letter, and a block whose order-0 Huffman code would
+  not be smaller than the block is stored raw, so it is copied at memory speed both ways.
+  The run-length, LZ77 and block sorting front ends can beat order-0 statistics (long runs
+  of bytes with a flat histogram), so they are always tried (encodeBlock still stores the
+  block if they expand it). The order-0 code lengths are left in codeLengths (if given),
+  so encodeBytes does not build them again.
+  */
+DPLKYL002::HuffmanTree::BlockType DPLKYL002::HuffmanTree::chooseBlockType(
+		const vector<unsigned int> & frequencies, size_t size,
+		FrontEnd frontEnd, vector<unsigned char> * codeLengths) {
+
+	if (find(frequencies.begin(), frequencies.end(), size)
+			!= frequencies.end()) {
+
+		return BLOCK_SINGLE;
+
+	}
+
+	if (frontEnd == FRONT_END_BYTES) {
+
+		vector<unsigned char> blockCodeLengths;
+		unsigned long long payloadBits = estimateHuffmanBits(frequencies,
+				codeLengths ? *codeLengths : blockCodeLengths) - 9 * 8;
+
+		if ((payloadBits + 7) / 8 >= size) {
+
+			return BLOCK_STORED;
+
+		}
+
+	}
+
+	return BLOCK_HUFFMAN;
+
+}
+
+// reads a block record header, a raw size of 0 marks the end of the blocks
+bool DPLKYL002::HuffmanTree::readBlockHeader(const bufferType & buffer,
+		size_t & position, size_t & rawSize, size_t & payloadSize,
+		BlockType & blockType) {
+
+	unsigned long long value;
+
+	if (!readInteger(buffer, position, 4, value)) {
+
+		return false;
+
+	}
+
+	rawSize = value;
+
+	if (rawSize == 0) {
+
+		return true;
+
+	}
+
+	if (!readInteger(buffer, position, 4, value) || position >= buffer.size()) {
+
+		return false;
+
+	}
+
+	payloadSize = value;
+	blockType = (BlockType) buffer[position++];
+
+	return position + payloadSize <= buffer.size();
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeBlock(const unsigned char * payload,
+		size_t payloadSize, BlockType blockType, FrontEnd frontEnd,
+		size_t rawSize, bufferType & output, const StaticTable * staticTable) {
+
+	if (blockType == BLOCK_SINGLE) {
+
+		if (payloadSize < 1) {
+
+			return false;
+
+		}
+
+		output.insert(output.end(), rawSize, payload[0]);
+		return true;
+
+	}
+
+	if (blockType == BLOCK_STORED) {
+
+		if (payloadSize != rawSize) {
+
+			return false;
+
+		}
+
+		output.insert(output.end(), payload, payload + payloadSize);
+		return true;
+
+	}
+
+	if (blockType == BLOCK_STATIC) {
+
+		return frontEnd == FRONT_END_TRAINED && staticTable != nullptr
+				&& decodeStatic(payload, payloadSize, rawSize, *staticTable,
+						output);
+
+	}
+
+	if (blockType != BLOCK_HUFFMAN) {
+
+		return false;
+
+	}
+
+	switch (frontEnd) {
+
+	case FRONT_END_BYTES:
+		return decodeBytes(payload, payloadSize, rawSize, output);
+
+	case FRONT_END_RLE:
+		return decodeRunLengths(payload, payloadSize, rawSize, output);
+
+	case FRONT_END_BWT:
+		return decodeBlockSorted(payload, payloadSize, rawSize, output);
+
+	case FRONT_END_LZ77:
+		return decodeLZ77(payload, payloadSize, rawSize, output);
+
+	default:
+		return false;
+
+	}
+
+}
+
+/*Order-0 front end: the symbols are the bytes themselves. The code lengths are built from
+  the block's histogram, unless the caller already has them (blockCodeLengths).
+  */
+void DPLKYL002::HuffmanTree::encodeBytes(const unsigned char * data,
+		size_t size, bufferType & payload, unsigned int threads,
+		const vector<unsigned char> * blockCodeLengths) {
+
+	vector<unsigned char> codeLengths;
+	vector<unsigned int> codes;
+
+	vector<unsigned int> packedCodes;
+
+	if (blockCodeLengths && !blockCodeLengths->empty()) {
+
+		codeLengths = *blockCodeLengths;
+
+	} else {
+
+		vector<unsigned int> frequencies(256, 0);
+
+		for (size_t i = 0; i < size; i++) {
+
+			frequencies[data[i]]++;
+
+		}
+
+		buildCodeLengths(frequencies, codeLengths);
+
+	}
+
+	buildCanonicalCodes(codeLengths, codes);
+	packCodes(codes, codeLengths, packedCodes);
+
+	BitWriter writer(payload);
+	writeCodeLengths(writer, codeLengths);
+	encodeSymbolsParallel(data, size, packedCodes.data(), writer, threads);
+	writer.flush();
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeBytes(const unsigned char * payload,
+		size_t payloadSize, size_t rawSize, bufferType & output) {
+
+	BitReader reader(payload, payloadSize);
+	vector<unsigned char> codeLengths;
+	shared_ptr<const DecodeTable> table;
+
+	if (!readCodeLengths(reader, codeLengths) || codeLengths.size() > 256
+			|| !(table = findDecodeTable(codeLengths))) {
+
+		return false;
+
+	}
+
+	size_t outputStart = output.size();
+	output.resize(outputStart + rawSize);
+
+	decodeSymbols(*table, reader, output.data() + outputStart, rawSize);
+
+	return !reader.overrun();
+
+}
+
+/*Run-length front end: a run of n identical bytes is coded as the byte followed by run
+  symbols covering the n - 1 repeats. Run symbol 256 + k stands for a repeat count in
+  [2^k, 2^(k+1)), with the low k bits of the count following the code as extra bits.
+  */
+void DPLKYL002::HuffmanTree::encodeRunLengths(const unsigned char * data,
+		size_t size, bufferType & payload) {
+
+	const unsigned int maxRun = (1u << numRunClasses) - 1;
+
+	vector<unsigned int> symbols, extraBits;
+
+	for (size_t i = 0; i < size;) {
+
+		size_t runEnd = i + 1;
+
+		while (runEnd < size && data[runEnd] == data[i]) {
+
+			runEnd++;
+
+		}
+
+		symbols.push_back(data[i]);
+		extraBits.push_back(0);
+
+		for (size_t repeats = runEnd - i - 1; repeats > 0;) {
+
+			unsigned int run = (unsigned int) min(repeats, (size_t) maxRun);
+			unsigned int runClass = 31 - __builtin_clz(run);
+
+			symbols.push_back(256 + runClass);
+			extraBits.push_back(run - (1u << runClass));
+			repeats -= run;
+
+		}
+
+		i = runEnd;
+
+	}
+
+	vector<unsigned int> frequencies(256 + numRunClasses, 0);
+
+	for (unsigned int symbol : symbols) {
+
+		frequencies[symbol]++;
+
+	}
+
+	vector<unsigned char> codeLengths;
+	vector<unsigned int> codes;
+
+	buildCodeLengths(frequencies, codeLengths);
+	buildCanonicalCodes(codeLengths, codes);
+
+	BitWriter writer(payload);
+	writeCodeLengths(writer, codeLengths);
+
+	for (size_t i = 0; i < symbols.size(); i++) {
+
+		unsigned int symbol = symbols[i];
+		writer.writeBits(codes[symbol], codeLengths[symbol]);
+
+		if (symbol >= 256) {
+
+			writer.writeBits(extraBits[i], symbol - 256);
+
+		}
+
+	}
+
+	writer.flush();
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeRunLengths(const unsigned char * payload,
+		size_t payloadSize, size_t rawSize, bufferType & output) {
+
+	BitReader reader(payload, payloadSize);
+	vector<unsigned char> codeLengths;
+	shared_ptr<const DecodeTable> table;
+
+	if (!readCodeLengths(reader, codeLengths)
+			|| codeLengths.size() > 256 + numRunClasses
+			|| !(table = findDecodeTable(codeLengths))) {
+
+		return false;
+
+	}
+
+	size_t outputEnd = output.size() + rawSize;
+	bool haveLetter = false;
+
+	while (output.size() < outputEnd) {
+
+		unsigned int symbol = table->decode(reader);
+
+		if (reader.overrun() || symbol >= 256 + numRunClasses) {
+
+			return false;
+
+		}
+
+		if (symbol < 256) {
+
+			output.push_back((unsigned char) symbol);
+			haveLetter = true;
+			continue;
+
+		}
+
+		unsigned int runClass = symbol - 256;
+		size_t run = (1u << runClass) + reader.readBits(runClass);
+
+		if (!haveLetter || output.size() + run > outputEnd) {
+
+			return false;
+
+		}
+
+		unsigned char letter = output.back();
+		output.insert(output.end(), run, letter);
+
+	}
+
+	return !reader.overrun();
+
+}
+
+// block sorting front end: primary index, then the code lengths and RUNA / RUNB / move-to-front symbols
+void DPLKYL002::HuffmanTree::encodeBlockSorted(const unsigned char * data,
+		size_t size, bufferType & payload) {
+
+	BlockSort blockSort;
+	vector<unsigned char> transformed, moved;
+	vector<unsigned short> symbols;
+
+	unsigned int primaryIndex = blockSort.transform(data, size, transformed);
+	blockSort.moveToFront(transformed, moved);
+	blockSort.encodeZeroRuns(moved, symbols);
+
+	vector<unsigned int> frequencies(BlockSort::numSymbols, 0);
+
+	for (unsigned short symbol : symbols) {
+
+		frequencies[symbol]++;
+
+	}
+
+	vector<unsigned char> codeLengths;
+	vector<unsigned int> codes;
+
+	buildCodeLengths(frequencies, codeLengths);
+	buildCanonicalCodes(codeLengths, codes);
+
+	appendInteger(payload, primaryIndex, 4);
+
+	BitWriter writer(payload);
+	writeCodeLengths(writer, codeLengths);
+
+	for (unsigned short symbol : symbols) {
+
+		writer.writeBits(codes[symbol], codeLengths[symbol]);
+
+	}
+
+	writer.flush();
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeBlockSorted(const unsigned char * payload,
+		size_t payloadSize, size_t rawSize, bufferType & output) {
+
+	if (payloadSize < 4) {
+
+		return false;
+
+	}
+
+	unsigned int primaryIndex = payload[0] | (payload[1] << 8)
+			| (payload[2] << 16) | ((unsigned int) payload[3] << 24);
+
+	BitReader reader(payload + 4, payloadSize - 4);
+	vector<unsigned char> codeLengths;
+	shared_ptr<const DecodeTable> table;
+
+	if (!readCodeLengths(reader, codeLengths)
+			|| codeLengths.size() > BlockSort::numSymbols
+			|| !(table = findDecodeTable(codeLengths))) {
+
+		return false;
+
+	}
+
+	// undo the zero run coding
+	vector<unsigned char> moved;
+	size_t run = 0, runWeight = 1;
+
+	moved.reserve(rawSize);
+
+	while (moved.size() + run < rawSize) {
+
+		unsigned int symbol = table->decode(reader);
+
+		if (reader.overrun() || symbol >= BlockSort::numSymbols) {
+
+			return false;
+
+		}
+
+		if (symbol == BlockSort::runA || symbol == BlockSort::runB) {
+
+			run += (symbol + 1) * runWeight;
+			runWeight <<= 1;
+
+			if (moved.size() + run > rawSize) {
+
+				return false;
+
+			}
+
+			continue;
+
+		}
+
+		moved.insert(moved.end(), run, 0);
+		moved.push_back(symbol - 1);
+		run = 0;
+		runWeight = 1;
+
+	}
+
+	moved.insert(moved.end(), run, 0);
+
+	BlockSort blockSort;
+	vector<unsigned char> transformed, original;
+
+	blockSort.inverseMoveToFront(moved, transformed);
+
+	if (!blockSort.inverseTransform(transformed.data(), transformed.size(),
+			primaryIndex, original)) {
+
+		return false;
+
+	}
+
+	output.insert(output.end(), original.begin(), original.end());
+
+	return true;
+
+}
+
+// LZ77 front end: literal / length code lengths, distance code lengths, then the tokens
+void DPLKYL002::HuffmanTree::encodeLZ77(const unsigned char * data, size_t size,
+		unsigned int level, bufferType & payload) {
+
+	LZ77 matchFinder(level);
+	vector<LZ77::Token> tokens;
+
+	matchFinder.findMatches(data, size, tokens);
+
+	vector<unsigned int> lengthFrequencies, distanceFrequencies;
+	vector<unsigned char> lengthCodeLengths, distanceCodeLengths;
+	vector<unsigned int> lengthCodes, distanceCodes;
+
+	countLZ77Symbols(tokens, lengthFrequencies, distanceFrequencies);
+
+	buildCodeLengths(lengthFrequencies, lengthCodeLengths);
+	buildCanonicalCodes(lengthCodeLengths, lengthCodes);
+	buildCodeLengths(distanceFrequencies, distanceCodeLengths);
+	buildCanonicalCodes(distanceCodeLengths, distanceCodes);
+
+	BitWriter writer(payload);
+	writeCodeLengths(writer, lengthCodeLengths);
+	writeCodeLengths(writer, distanceCodeLengths);
+	writeLZ77Tokens(writer, tokens, lengthCodeLengths, lengthCodes,
+			distanceCodeLengths, distanceCodes);
+	writer.flush();
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeLZ77(const unsigned char * payload,
+		size_t payloadSize, size_t rawSize, bufferType & output) {
+
+	BitReader reader(payload, payloadSize);
+	vector<unsigned char> lengthCodeLengths, distanceCodeLengths;
+	shared_ptr<const DecodeTable> lengthTable, distanceTable;
+
+	if (!readCodeLengths(reader, lengthCodeLengths)
+			|| !readCodeLengths(reader, distanceCodeLengths)
+			|| lengthCodeLengths.size() > LZ77::numLengthSymbols
+			|| distanceCodeLengths.size() > LZ77::numDistanceSymbols
+			|| !(lengthTable = findDecodeTable(lengthCodeLengths))
+			|| !(distanceTable = findDecodeTable(distanceCodeLengths))) {
+
+		return false;
+
+	}
+
+	size_t outputStart = output.size();
+	size_t position = 0;
+
+	output.resize(outputStart + rawSize);
+
+	unsigned char * letter = output.data() + outputStart;
+
+	while (position < rawSize) {
+
+		unsigned int symbol = lengthTable->decode(reader);
+
+		if (symbol < 256) {
+
+			letter[position++] = (unsigned char) symbol;
+			continue;
+
+		}
+
+		if (symbol <= LZ77::endOfBlock || symbol >= LZ77::numLengthSymbols) {
+
+			return false;
+
+		}
+
+		unsigned int code = symbol - 257;
+		unsigned int length = LZ77::lengthBase[code]
+				+ reader.readBits(LZ77::lengthExtraBits[code]);
+
+		code = distanceTable->decode(reader);
+
+		if (code >= LZ77::numDistanceSymbols) {
+
+			return false;
+
+		}
+
+		unsigned int distance = LZ77::distanceBase[code]
+				+ reader.readBits(LZ77::distanceExtraBits[code]);
+
+		if (distance > position || length > rawSize - position
+				|| reader.overrun()) {
+
+			return false;
+
+		}
+
+		// byte by byte, as the match may overlap the letters it produces
+		for (unsigned int i = 0; i < length; i++, position++) {
+
+			letter[position] = letter[position - distance];
+
+		}
+
+	}
+
+	return !reader.overrun();
+
+}
+
+void DPLKYL002::HuffmanTree::countLZ77Symbols(
+		const vector<LZ77::Token> & tokens,
+		vector<unsigned int> & lengthFrequencies,
+		vector<unsigned int> & distanceFrequencies) {
+
+	unsigned int numExtraBits, extraBits;
+
+	lengthFrequencies.assign(LZ77::numLengthSymbols, 0);
+	distanceFrequencies.assign(LZ77::numDistanceSymbols, 0);
+
+	for (const auto & token : tokens) {
+
+		if (token.length == 0) {
+
+			lengthFrequencies[token.literal]++;
+
+		} else {
+
+			lengthFrequencies[LZ77::lengthSymbol(token.length, numExtraBits,
+					extraBits)]++;
+			distanceFrequencies[LZ77::distanceSymbol(token.distance,
+					numExtraBits, extraBits)]++;
+
+		}
+
+	}
+
+}
+
+void DPLKYL002::HuffmanTree::writeLZ77Tokens(BitWriter & writer,
+		const vector<LZ77::Token> & tokens,
+		const vector<unsigned char> & lengthCodeLengths,
+		const vector<unsigned int> & lengthCodes,
+		const vector<unsigned char> & distanceCodeLengths,
+		const vector<unsigned int> & distanceCodes) {
+
+	unsigned int numExtraBits, extraBits;
+
+	for (const auto & token : tokens) {
+
+		if (token.length == 0) {
+
+			writer.writeBits(lengthCodes[token.literal],
+					lengthCodeLengths[token.literal]);
+			continue;
+
+		}
+
+		unsigned int symbol = LZ77::lengthSymbol(token.length, numExtraBits,
+				extraBits);
+
+		writer.writeBits(lengthCodes[symbol], lengthCodeLengths[symbol]);
+		writer.writeBits(extraBits, numExtraBits);
+
+		symbol = LZ77::distanceSymbol(token.distance, numExtraBits, extraBits);
+
+		writer.writeBits(distanceCodes[symbol], distanceCodeLengths[symbol]);
+		writer.writeBits(extraBits, numExtraBits);
+
+	}
+
+}
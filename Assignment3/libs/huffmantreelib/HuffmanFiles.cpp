@@ -0,0 +1,351 @@
+//=======================================================================================
+// Name        : HuffmanFiles.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+const string DPLKYL002::HuffmanTree::containerExtension = ".dplh";
+
+namespace {
+
+// the regular files below directory, in name order, with their paths relative to it
+bool listDirectory(string directory, string relative,
+		vector<pair<string, string>> & files) {
+
+	DIR * entries = opendir(directory.c_str());
+
+	if (entries == nullptr) {
+
+		return false;
+
+	}
+
+	vector<string> names;
+
+	for (dirent * entry = readdir(entries); entry != nullptr;
+			entry = readdir(entries)) {
+
+		string name = entry->d_name;
+
+		if (name != "." && name != "..") {
+
+			names.push_back(name);
+
+		}
+
+	}
+
+	closedir(entries);
+	sort(names.begin(), names.end());
+
+	for (const auto & name : names) {
+
+		string path = directory + "/" + name;
+		struct stat status;
+
+		if (stat(path.c_str(), &status) != 0) {
+
+			continue;
+
+		}
+
+		if (S_ISDIR(status.st_mode)) {
+
+			listDirectory(path, relative + name + "/", files);
+
+		} else if (S_ISREG(status.st_mode)) {
+
+			files.push_back( { path, relative + name });
+
+		}
+
+	}
+
+	return true;
+
+}
+
+}
+
+/*Adds the files named by path to files as (input path, output path relative to the output
+  directory) pairs: a file is compressed to its own name, a directory to the same tree of
+  names.
+  */
+bool DPLKYL002::HuffmanTree::listInputFiles(string path,
+		vector<pair<string, string>> & files) {
+
+	struct stat status;
+
+	if (stat(path.c_str(), &status) != 0) {
+
+		cout << "Unable to open: " << path << endl;
+		return false;
+
+	}
+
+	if (S_ISDIR(status.st_mode)) {
+
+		while (path.size() > 1 && path.back() == '/') {
+
+			path.pop_back();
+
+		}
+
+		return listDirectory(path, "", files);
+
+	}
+
+	size_t slash = path.find_last_of('/');
+
+	files.push_back( { path, slash == string::npos ? path : path.substr(slash + 1) });
+
+	return true;
+
+}
+
+// mkdir -p
+bool DPLKYL002::HuffmanTree::makeDirectories(string path) {
+
+	for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+
+		string directory = path.substr(0, slash);
+
+		if (!directory.empty() && mkdir(directory.c_str(), 0755) != 0
+				&& errno != EEXIST) {
+
+			return false;
+
+		}
+
+		if (slash == string::npos) {
+
+			return true;
+
+		}
+
+	}
+
+}
+
+/*Compresses every file under paths into outputDirectory as block containers, jobs files
+  at a time. Each job takes the next file still to be done, so a few large files do not
+  hold up the rest; threads left over when there are fewer jobs than threads split each
+  file's blocks. The files are read and written whole (not through the pipeline, whose
+  reader and writer would block tasks of the pool). A file whose output name is already
+  taken (e.g. d1/x.txt and d2/x.txt, both x.txt.dplh) is counted as failed, so no two jobs
+  write the same file.
+  */
+DPLKYL002::HuffmanTree::FilesReport DPLKYL002::HuffmanTree::compressFiles(
+		const vector<string> & paths, string outputDirectory,
+		const Options & options, unsigned int jobs) {
+
+	auto start = chrono::steady_clock::now();
+
+	FilesReport report;
+	vector<pair<string, string>> files;
+
+	for (const auto & path : paths) {
+
+		if (!listInputFiles(path, files)) {
+
+			report.numFailed++;
+
+		}
+
+	}
+
+	report.numFiles = files.size() + report.numFailed;
+
+	// output names are settled before any job starts
+	vector<pair<string, string>> outputs;
+	set<string> outputFileNames;
+
+	for (const auto & file : files) {
+
+		string outputFileName = outputDirectory + "/" + file.second
+				+ containerExtension;
+
+		if (!outputFileNames.insert(outputFileName).second) {
+
+			cout << "Duplicate output name: " << outputFileName << endl;
+			report.numFailed++;
+			continue;
+
+		}
+
+		outputs.push_back( { file.first, outputFileName });
+
+	}
+
+	files.swap(outputs);
+	jobs = max(1u, min(jobs, (unsigned int) max((size_t) 1, files.size())));
+
+	Options fileOptions(options);
+	fileOptions.threads = max(1u, options.threads / jobs);
+
+	atomic<size_t> nextFile(0), numFailed(0);
+	atomic<unsigned long long> inputBytes(0), outputBytes(0);
+
+	ThreadPool::shared().forEach(jobs, [&](size_t) {
+
+		HuffmanTree tree;
+
+		for (size_t f = nextFile++; f < files.size(); f = nextFile++) {
+
+			const string & outputFileName = files[f].second;
+			size_t slash = outputFileName.find_last_of('/');
+			bufferType input, output;
+
+			if (!tree.makeDirectories(outputFileName.substr(0, slash))
+					|| !tree.readFile(files[f].first, input, fileOptions)) {
+
+				numFailed++;
+				continue;
+
+			}
+
+			if (!tree.compressBuffer(input, output, fileOptions)
+					|| !tree.writeFile(outputFileName, output, fileOptions)) {
+
+				numFailed++;
+				continue;
+
+			}
+
+			inputBytes += input.size();
+			outputBytes += output.size();
+
+		}
+
+	});
+
+	report.numFailed += numFailed;
+	report.inputBytes = inputBytes;
+	report.outputBytes = outputBytes;
+	report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	return report;
+
+}
+
+DPLKYL002::HuffmanTree::FileFormat DPLKYL002::HuffmanTree::detectFormat(
+		string fileName) {
+
+	ifstream inputFile(fileName.c_str(), ios::binary);
+	char magic[4] = { 0 };
+
+	inputFile.read(magic, 4);
+
+	if (inputFile.gcount() == 4 && string(magic, 4) == "DPLH") {
+
+		return FORMAT_CONTAINER;
+
+	}
+
+	if (inputFile.gcount() >= 2 && (unsigned char) magic[0] == 0x1F
+			&& (unsigned char) magic[1] == 0x8B) {
+
+		return FORMAT_GZIP;
+
+	}
+
+	// the legacy output file holds the bits as text; the .hdr and .bin files are decoded
+	struct stat status;
+
+	if (stat((fileName + ".hdr").c_str(), &status) == 0
+			&& stat((fileName + ".bin").c_str(), &status) == 0) {
+
+		return FORMAT_LEGACY;
+
+	}
+
+	return FORMAT_UNKNOWN;
+
+}
+
+// decompresses a file of any format except the built-in English model (which has no header)
+bool DPLKYL002::HuffmanTree::decompressFile(string inputFileName,
+		bufferType & output, const Options & options) {
+
+	bufferType input;
+	string letters;
+
+	switch (detectFormat(inputFileName)) {
+
+	case FORMAT_CONTAINER:
+
+		if (!readFile(inputFileName, input, options)) {
+
+			return false;
+
+		}
+
+		output.clear();
+
+		if (!decompressBuffer(input, output, options)) {
+
+			cout << "Corrupt compressed file: " << inputFileName << endl;
+			return false;
+
+		}
+
+		return true;
+
+	case FORMAT_GZIP:
+
+		if (!readFile(inputFileName, input, options)) {
+
+			return false;
+
+		}
+
+		output.clear();
+
+		if (!decodeGzip(input, output)) {
+
+			cout << "Corrupt gzip file: " << inputFileName << endl;
+			return false;
+
+		}
+
+		return true;
+
+	case FORMAT_LEGACY:
+
+		if (!decodeLegacyFiles(inputFileName, letters, options)) {
+
+			return false;
+
+		}
+
+		output.assign(letters.begin(), letters.end());
+
+		return true;
+
+	default:
+
+		cout << "Unknown file format: " << inputFileName << endl;
+		return false;
+
+	}
+
+}
@@ -0,0 +1,566 @@
+//=======================================================================================
+// Name        : HuffmanGzip.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// order in which the code length code lengths are stored (RFC 1951, section 3.2.7)
+const unsigned char codeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5,
+		11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// extra bits of the code length symbols 16 (repeat previous), 17 and 18 (repeat zero)
+const unsigned int repeatExtraBits[3] = { 2, 3, 7 };
+
+}
+
+/*gzip output (RFC 1952 framing around RFC 1951 DEFLATE data) so the compressed file can
+  be read by standard tools. Each block of the input becomes one dynamic Huffman block.
+  */
+bool DPLKYL002::HuffmanTree::compressGzip(string inputFileName,
+		string outputFileName, const Options & options) {
+
+	bufferType input, output;
+
+	if (!readFile(inputFileName, input, options)) {
+
+		return false;
+
+	}
+
+	encodeGzip(input, output, options);
+
+	return writeFile(outputFileName, output, options);
+
+}
+
+bool DPLKYL002::HuffmanTree::decompressGzip(string inputFileName,
+		string outputFileName, const Options & options) {
+
+	bufferType input, output;
+
+	if (!readFile(inputFileName, input, options)) {
+
+		return false;
+
+	}
+
+	if (!decodeGzip(input, output)) {
+
+		cout << "Corrupt gzip file: " << inputFileName << endl;
+		return false;
+
+	}
+
+	return writeFile(outputFileName, output, options);
+
+}
+
+void DPLKYL002::HuffmanTree::encodeGzip(const bufferType & input,
+		bufferType & output, const Options & options) {
+
+	// header: magic, DEFLATE method, no flags, no modification time, no extra flags, Unix
+	const unsigned char header[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 3 };
+
+	output.insert(output.end(), header, header + 10);
+
+	BitWriter writer(output);
+
+	if (input.empty()) {
+
+		// a final fixed Huffman block holding only the end of block code (7 zero bits)
+		writer.writeBits(1, 1);
+		writer.writeBits(1, 2);
+		writer.writeBits(0, 7);
+
+	}
+
+	size_t blockSize = max(1u, options.blockSize);
+	LZ77 matchFinder(options.level);
+	vector<LZ77::Token> tokens;
+
+	for (size_t offset = 0; offset < input.size(); offset += blockSize) {
+
+		size_t size = min(blockSize, input.size() - offset);
+
+		matchFinder.findMatches(input.data() + offset, size, tokens);
+		encodeDeflateBlock(writer, tokens, offset + size == input.size());
+
+	}
+
+	writer.flush();
+
+	// trailer: CRC-32 and size of the uncompressed data
+	appendInteger(output, crc32(input.data(), input.size()), 4);
+	appendInteger(output, input.size() & 0xFFFFFFFF, 4);
+
+}
+
+void DPLKYL002::HuffmanTree::encodeDeflateBlock(BitWriter & writer,
+		const vector<LZ77::Token> & tokens, bool lastBlock) {
+
+	vector<unsigned int> lengthFrequencies, distanceFrequencies;
+	vector<unsigned char> lengthCodeLengths, distanceCodeLengths;
+	vector<unsigned int> lengthCodes, distanceCodes;
+
+	countLZ77Symbols(tokens, lengthFrequencies, distanceFrequencies);
+	lengthFrequencies[LZ77::endOfBlock] = 1;
+
+	// a block without matches still describes one distance code
+	if (all_of(distanceFrequencies.begin(), distanceFrequencies.end(),
+			[](unsigned int frequency) {return frequency == 0;})) {
+
+		distanceFrequencies[0] = 1;
+
+	}
+
+	buildCodeLengths(lengthFrequencies, lengthCodeLengths);
+	buildCanonicalCodes(lengthCodeLengths, lengthCodes);
+	buildCodeLengths(distanceFrequencies, distanceCodeLengths);
+	buildCanonicalCodes(distanceCodeLengths, distanceCodes);
+
+	unsigned int numLengthCodes = LZ77::numLengthSymbols;
+	unsigned int numDistanceCodes = LZ77::numDistanceSymbols;
+
+	while (numLengthCodes > 257 && lengthCodeLengths[numLengthCodes - 1] == 0) {
+
+		numLengthCodes--;
+
+	}
+
+	while (numDistanceCodes > 1
+			&& distanceCodeLengths[numDistanceCodes - 1] == 0) {
+
+		numDistanceCodes--;
+
+	}
+
+	/*Both sets of code lengths are sent as one sequence, run-length coded with symbols
+	  16 (repeat the previous length 3 - 6 times), 17 (3 - 10 zeros) and 18 (11 - 138 zeros).
+	  */
+	vector<unsigned char> codeLengths(lengthCodeLengths.begin(),
+			lengthCodeLengths.begin() + numLengthCodes);
+	vector<unsigned int> symbols, extraBits;
+
+	codeLengths.insert(codeLengths.end(), distanceCodeLengths.begin(),
+			distanceCodeLengths.begin() + numDistanceCodes);
+
+	for (size_t i = 0; i < codeLengths.size();) {
+
+		unsigned char length = codeLengths[i];
+		size_t run = 1;
+
+		while (i + run < codeLengths.size() && codeLengths[i + run] == length) {
+
+			run++;
+
+		}
+
+		if (length == 0 && run >= 3) {
+
+			size_t repeat = min(run, (size_t) 138);
+
+			symbols.push_back(repeat >= 11 ? 18 : 17);
+			extraBits.push_back(repeat - (repeat >= 11 ? 11 : 3));
+			i += repeat;
+
+			continue;
+
+		}
+
+		symbols.push_back(length);
+		extraBits.push_back(0);
+		i++;
+
+		for (run--; length != 0 && run >= 3;) {
+
+			size_t repeat = min(run, (size_t) 6);
+
+			symbols.push_back(16);
+			extraBits.push_back(repeat - 3);
+			i += repeat;
+			run -= repeat;
+
+		}
+
+	}
+
+	vector<unsigned int> codeLengthFrequencies(19, 0);
+	vector<unsigned char> codeLengthCodeLengths;
+	vector<unsigned int> codeLengthCodes;
+
+	for (unsigned int symbol : symbols) {
+
+		codeLengthFrequencies[symbol]++;
+
+	}
+
+	// inflaters reject an incomplete code length code, so make sure it has two symbols
+	if (count(codeLengthFrequencies.begin(), codeLengthFrequencies.end(), 0u)
+			== 18) {
+
+		codeLengthFrequencies[codeLengthFrequencies[0] == 0 ? 0 : 1] = 1;
+
+	}
+
+	buildCodeLengths(codeLengthFrequencies, codeLengthCodeLengths, 7);
+	buildCanonicalCodes(codeLengthCodeLengths, codeLengthCodes);
+
+	unsigned int numCodeLengthCodes = 19;
+
+	while (numCodeLengthCodes > 4
+			&& codeLengthCodeLengths[codeLengthOrder[numCodeLengthCodes - 1]]
+					== 0) {
+
+		numCodeLengthCodes--;
+
+	}
+
+	// block header
+	writer.writeBits(lastBlock ? 1 : 0, 1);
+	writer.writeBits(2, 2); // dynamic Huffman codes
+	writer.writeBits(numLengthCodes - 257, 5);
+	writer.writeBits(numDistanceCodes - 1, 5);
+	writer.writeBits(numCodeLengthCodes - 4, 4);
+
+	for (unsigned int i = 0; i < numCodeLengthCodes; i++) {
+
+		writer.writeBits(codeLengthCodeLengths[codeLengthOrder[i]], 3);
+
+	}
+
+	for (size_t i = 0; i < symbols.size(); i++) {
+
+		unsigned int symbol = symbols[i];
+
+		writer.writeBits(codeLengthCodes[symbol], codeLengthCodeLengths[symbol]);
+
+		if (symbol >= 16) {
+
+			writer.writeBits(extraBits[i], repeatExtraBits[symbol - 16]);
+
+		}
+
+	}
+
+	// block data
+	writeLZ77Tokens(writer, tokens, lengthCodeLengths, lengthCodes,
+			distanceCodeLengths, distanceCodes);
+	writer.writeBits(lengthCodes[LZ77::endOfBlock],
+			lengthCodeLengths[LZ77::endOfBlock]);
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeGzip(const bufferType & input,
+		bufferType & output) {
+
+	if (input.size() < 18 || input[0] != 0x1F || input[1] != 0x8B
+			|| input[2] != 8) {
+
+		return false;
+
+	}
+
+	unsigned int flags = input[3];
+	size_t position = 10;
+
+	// skip the optional header fields: extra field, file name, comment and header CRC
+	if (flags & 4) {
+
+		position += 2 + (input[position] | (input[position + 1] << 8));
+
+	}
+
+	for (unsigned int flag = 8; flag <= 16; flag <<= 1) {
+
+		if (flags & flag) {
+
+			while (position < input.size() && input[position] != 0) {
+
+				position++;
+
+			}
+
+			position++;
+
+		}
+
+	}
+
+	if (flags & 2) {
+
+		position += 2;
+
+	}
+
+	if (position >= input.size()) {
+
+		return false;
+
+	}
+
+	BitReader reader(input.data() + position, input.size() - position);
+	size_t outputStart = output.size();
+	bool lastBlock = false;
+
+	while (!lastBlock) {
+
+		lastBlock = reader.readBits(1);
+
+		if (!decodeDeflateBlock(reader, reader.readBits(2), output)
+				|| reader.overrun()) {
+
+			return false;
+
+		}
+
+	}
+
+	reader.alignToByte();
+	position += reader.getPosition() / 8;
+
+	unsigned long long crc, size;
+
+	if (!readInteger(input, position, 4, crc)
+			|| !readInteger(input, position, 4, size)) {
+
+		return false;
+
+	}
+
+	return crc
+			== crc32(output.data() + outputStart, output.size() - outputStart)
+			&& size == ((output.size() - outputStart) & 0xFFFFFFFF);
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeDeflateBlock(BitReader & reader,
+		unsigned int blockType, bufferType & output) {
+
+	// stored block
+	if (blockType == 0) {
+
+		reader.alignToByte();
+
+		unsigned int length = reader.readBits(16);
+
+		if ((reader.readBits(16) ^ 0xFFFF) != length) {
+
+			return false;
+
+		}
+
+		for (unsigned int i = 0; i < length && !reader.overrun(); i++) {
+
+			output.push_back(reader.readBits(8));
+
+		}
+
+		return !reader.overrun();
+
+	}
+
+	vector<unsigned char> lengthCodeLengths, distanceCodeLengths;
+
+	if (blockType == 1) {
+
+		// fixed Huffman codes
+		lengthCodeLengths.assign(288, 8);
+		fill(lengthCodeLengths.begin() + 144, lengthCodeLengths.begin() + 256,
+				9);
+		fill(lengthCodeLengths.begin() + 256, lengthCodeLengths.begin() + 280,
+				7);
+		distanceCodeLengths.assign(30, 5);
+
+	} else if (blockType == 2) {
+
+		unsigned int numLengthCodes = reader.readBits(5) + 257;
+		unsigned int numDistanceCodes = reader.readBits(5) + 1;
+		unsigned int numCodeLengthCodes = reader.readBits(4) + 4;
+
+		vector<unsigned char> codeLengthCodeLengths(19, 0);
+
+		for (unsigned int i = 0; i < numCodeLengthCodes; i++) {
+
+			codeLengthCodeLengths[codeLengthOrder[i]] = reader.readBits(3);
+
+		}
+
+		shared_ptr<const DecodeTable> codeLengthTable = findDecodeTable(
+				codeLengthCodeLengths);
+
+		if (!codeLengthTable) {
+
+			return false;
+
+		}
+
+		vector<unsigned char> codeLengths;
+
+		while (codeLengths.size() < numLengthCodes + numDistanceCodes) {
+
+			unsigned int symbol = codeLengthTable->decode(reader);
+
+			if (reader.overrun() || symbol >= 19) {
+
+				return false;
+
+			}
+
+			if (symbol < 16) {
+
+				codeLengths.push_back(symbol);
+				continue;
+
+			}
+
+			if (symbol == 16 && codeLengths.empty()) {
+
+				return false;
+
+			}
+
+			unsigned char length = symbol == 16 ? codeLengths.back() : 0;
+			unsigned int repeat = reader.readBits(repeatExtraBits[symbol - 16])
+					+ (symbol == 18 ? 11 : 3);
+
+			codeLengths.insert(codeLengths.end(), repeat, length);
+
+		}
+
+		if (codeLengths.size() != numLengthCodes + numDistanceCodes) {
+
+			return false;
+
+		}
+
+		lengthCodeLengths.assign(codeLengths.begin(),
+				codeLengths.begin() + numLengthCodes);
+		distanceCodeLengths.assign(codeLengths.begin() + numLengthCodes,
+				codeLengths.end());
+
+	} else {
+
+		return false;
+
+	}
+
+	shared_ptr<const DecodeTable> lengthTable = findDecodeTable(lengthCodeLengths);
+	shared_ptr<const DecodeTable> distanceTable = findDecodeTable(
+			distanceCodeLengths);
+
+	if (!lengthTable || !distanceTable) {
+
+		return false;
+
+	}
+
+	while (true) {
+
+		unsigned int symbol = lengthTable->decode(reader);
+
+		if (reader.overrun()) {
+
+			return false;
+
+		}
+
+		if (symbol < 256) {
+
+			output.push_back(symbol);
+			continue;
+
+		}
+
+		if (symbol == LZ77::endOfBlock) {
+
+			return true;
+
+		}
+
+		if (symbol >= LZ77::numLengthSymbols) {
+
+			return false;
+
+		}
+
+		unsigned int code = symbol - 257;
+		unsigned int length = LZ77::lengthBase[code]
+				+ reader.readBits(LZ77::lengthExtraBits[code]);
+
+		code = distanceTable->decode(reader);
+
+		if (code >= LZ77::numDistanceSymbols) {
+
+			return false;
+
+		}
+
+		unsigned int distance = LZ77::distanceBase[code]
+				+ reader.readBits(LZ77::distanceExtraBits[code]);
+
+		if (distance > output.size()) {
+
+			return false;
+
+		}
+
+		for (unsigned int i = 0; i < length; i++) {
+
+			unsigned char letter = output[output.size() - distance];
+			output.push_back(letter);
+
+		}
+
+	}
+
+}
+
+unsigned int DPLKYL002::HuffmanTree::crc32(const unsigned char * data,
+		size_t size, unsigned int crc) {
+
+	// table for the reflected CRC-32 polynomial used by gzip
+	static const vector<unsigned int> table = []() {
+
+		vector<unsigned int> entries(256);
+
+		for (unsigned int n = 0; n < 256; n++) {
+
+			unsigned int c = n;
+
+			for (unsigned int k = 0; k < 8; k++) {
+
+				c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+
+			}
+
+			entries[n] = c;
+
+		}
+
+		return entries;
+
+	}();
+
+	crc = ~crc;
+
+	for (size_t i = 0; i < size; i++) {
+
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+	}
+
+	return ~crc;
+
+}
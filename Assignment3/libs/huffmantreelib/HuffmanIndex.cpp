@@ -0,0 +1,361 @@
+//=======================================================================================
+// Name        : HuffmanIndex.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+const string DPLKYL002::HuffmanTree::indexExtension = ".idx";
+
+/*Index layout: the magic bytes "DPLI", the sync interval (4 bytes), the number of letters
+  in the file and the number of sync points (8 bytes each), then the bit offset into the
+  .bin stream of letters 0, syncInterval, 2 * syncInterval, ... (8 bytes each).
+  */
+namespace {
+
+const unsigned int indexHeaderSize = 24;
+const unsigned int binaryHeaderSize = sizeof(int) + 1; // bit count and '\n' of a .bin file
+
+// bytes [offset, offset + size) of an open file
+bool readRange(int fd, unsigned long long offset, size_t size,
+		DPLKYL002::HuffmanTree::bufferType & buffer,
+		DPLKYL002::FileIO::Backend backend) {
+
+	buffer.resize(size);
+
+	return DPLKYL002::FileIO::readAt(fd, buffer.data(), size, offset, backend)
+			== (long long) size;
+
+}
+
+// ranges are read with pread / io_uring (not iostreams, and not O_DIRECT)
+DPLKYL002::FileIO::Backend indexBackend(
+		const DPLKYL002::HuffmanTree::Options & options) {
+
+	return options.backend == DPLKYL002::FileIO::BACKEND_URING ?
+			DPLKYL002::FileIO::BACKEND_URING : DPLKYL002::FileIO::BACKEND_PREAD;
+
+}
+
+// letters [offset, offset + length) of a decoded buffer, cut short at its end
+void cutRange(const DPLKYL002::HuffmanTree::bufferType & letters,
+		unsigned long long offset, unsigned long long length,
+		DPLKYL002::HuffmanTree::bufferType & output) {
+
+	if (offset < letters.size()) {
+
+		output.assign(letters.begin() + offset,
+				letters.begin() + offset + min(length, letters.size() - offset));
+
+	}
+
+}
+
+}
+
+// output file (sync point index)
+void DPLKYL002::HuffmanTree::createIndexFile(string outputFileName,
+		const vector<unsigned long long> & syncPoints,
+		unsigned long long numLetters, unsigned int syncInterval,
+		const Options & options) {
+
+	const char magic[] = "DPLI";
+	bufferType outputFile(magic, magic + 4);
+
+	appendInteger(outputFile, syncInterval, 4);
+	appendInteger(outputFile, numLetters, 8);
+	appendInteger(outputFile, syncPoints.size(), 8);
+
+	for (unsigned long long syncPoint : syncPoints) {
+
+		appendInteger(outputFile, syncPoint, 8);
+
+	}
+
+	writeFile(outputFileName + indexExtension, outputFile, options);
+
+}
+
+/*Decodes letters [offset, offset + length) of a compressed file. For a legacy file with an
+  index, only the .bin bytes between the sync points either side of the range are read and
+  decoded, and for a block container only the blocks overlapping the range are, so the cost
+  follows the length of the range rather than its offset. Any other file is decompressed
+  whole and the range is cut out of it. A range past the end of the file is cut short.
+  */
+bool DPLKYL002::HuffmanTree::decompressRange(string inputFileName,
+		unsigned long long offset, unsigned long long length, bufferType & output,
+		const Options & options) {
+
+	output.clear();
+
+	bufferType index;
+	int fd = -1;
+	unsigned long long fileSize;
+
+	FileFormat format = detectFormat(inputFileName);
+
+	if (format == FORMAT_CONTAINER) {
+
+		return decompressContainerRange(inputFileName, offset, length, output,
+				options);
+
+	}
+
+	if (format == FORMAT_LEGACY) {
+
+		fd = FileIO::openFile(inputFileName + indexExtension, false);
+
+	}
+
+	bool indexed = fd >= 0 && FileIO::fileSize(fd, fileSize)
+			&& readRange(fd, 0, fileSize, index, FileIO::BACKEND_PREAD);
+
+	FileIO::closeFile(fd);
+
+	if (!indexed) {
+
+		bufferType letters;
+
+		if (!decompressFile(inputFileName, letters, options)) {
+
+			return false;
+
+		}
+
+		cutRange(letters, offset, length, output);
+
+		return true;
+
+	}
+
+	unsigned long long syncInterval = 0, numLetters = 0, numSyncPoints = 0;
+	size_t position = 4;
+	bool valid = index.size() >= indexHeaderSize
+			&& string(index.begin(), index.begin() + 4) == "DPLI"
+			&& readInteger(index, position, 4, syncInterval)
+			&& readInteger(index, position, 8, numLetters)
+			&& readInteger(index, position, 8, numSyncPoints)
+			&& syncInterval > 0
+			&& numSyncPoints == (numLetters + syncInterval - 1) / syncInterval
+			&& index.size() - indexHeaderSize == 8 * numSyncPoints;
+
+	vector<unsigned long long> syncPoints(valid ? numSyncPoints : 0);
+
+	for (auto & syncPoint : syncPoints) {
+
+		readInteger(index, position, 8, syncPoint);
+
+	}
+
+	if (!valid || !is_sorted(syncPoints.begin(), syncPoints.end())) {
+
+		cout << "Corrupt index file: " << inputFileName + indexExtension << endl;
+		return false;
+
+	}
+
+	if (offset >= numLetters || length == 0) {
+
+		return true;
+
+	}
+
+	unsigned long long end = offset + min(length, numLetters - offset);
+
+	unordered_map<string, string> map;
+	vector<int> links;
+
+	if (!readCodeTableFile(inputFileName, map)) {
+
+		return false;
+
+	}
+
+	buildLegacyCode(map, links);
+
+	// the sync point at or before the range, and the one after it (or the end of the stream)
+	unsigned long long first = offset / syncInterval;
+	unsigned long long last = (end + syncInterval - 1) / syncInterval;
+
+	fd = FileIO::openFile(inputFileName + ".bin", false);
+
+	bufferType header, byteArr;
+	int numBits = 0;
+
+	valid = fd >= 0
+			&& readRange(fd, 0, binaryHeaderSize, header, indexBackend(options));
+
+	if (valid) {
+
+		memcpy(&numBits, header.data(), sizeof(int));
+
+	}
+
+	unsigned long long startBit = syncPoints[first];
+	unsigned long long endBit =
+			last < syncPoints.size() ?
+					syncPoints[last] : (unsigned long long) max(0, numBits);
+
+	valid = valid && numBits >= 0 && startBit <= endBit
+			&& endBit <= (unsigned long long) numBits;
+
+	// only the bytes holding the codes between the two sync points are read
+	unsigned long long firstByte = startBit / 8;
+
+	valid = valid
+			&& readRange(fd, binaryHeaderSize + firstByte,
+					(endBit + 7) / 8 - firstByte, byteArr, indexBackend(options));
+
+	FileIO::closeFile(fd);
+
+	if (!valid) {
+
+		cout << "Corrupt compressed file: " << inputFileName + ".bin" << endl;
+		return false;
+
+	}
+
+	// skip to the first letter of the range, then decode the range itself
+	string letters;
+	unsigned long long bit = startBit - 8 * firstByte;
+	unsigned long long numSkipped = offset - first * syncInterval;
+
+	if (decodeLegacyLetters(links, byteArr.data(), endBit - 8 * firstByte, bit,
+			numSkipped, nullptr) != numSkipped
+			|| decodeLegacyLetters(links, byteArr.data(), endBit - 8 * firstByte, bit,
+					end - offset, &letters) != end - offset) {
+
+		cout << "Corrupt compressed file: " << inputFileName + ".bin" << endl;
+		return false;
+
+	}
+
+	output.assign(letters.begin(), letters.end());
+
+	return true;
+
+}
+
+/*Range of a block container: only the 9 byte block records are read up to the first block
+  overlapping the range (their raw sizes give each block's first letter), then the payloads
+  of the blocks holding the range are read and decoded, stopping after the block that holds
+  its end. Word containers are not split into blocks, so they are decoded whole.
+  */
+bool DPLKYL002::HuffmanTree::decompressContainerRange(string inputFileName,
+		unsigned long long offset, unsigned long long length, bufferType & output,
+		const Options & options) {
+
+	FileIO::Backend backend = indexBackend(options);
+	int fd = FileIO::openFile(inputFileName, false);
+	unsigned long long fileSize = 0, tableId, blockSize;
+	size_t position = 0;
+	FrontEnd frontEnd;
+	StaticTable staticTable;
+	bufferType header, letters;
+
+	// container header, then the table ID of a trained container and the block size
+	bool valid = fd >= 0 && FileIO::fileSize(fd, fileSize)
+			&& readRange(fd, 0, min(fileSize, 16ULL), header, backend)
+			&& readContainerHeader(header, position, frontEnd);
+
+	if (valid && frontEnd == FRONT_END_WORDS) {
+
+		bufferType input;
+
+		valid = readRange(fd, 0, fileSize, input, backend)
+				&& decompressBuffer(input, letters, options);
+
+		FileIO::closeFile(fd);
+
+		if (!valid) {
+
+			cout << "Corrupt compressed file: " << inputFileName << endl;
+			return false;
+
+		}
+
+		cutRange(letters, offset, length, output);
+
+		return true;
+
+	}
+
+	valid = valid
+			&& (frontEnd != FRONT_END_TRAINED
+					|| (readInteger(header, position, 4, tableId)
+							&& loadTable(options.tableDirectory, tableId, staticTable)))
+			&& readInteger(header, position, 4, blockSize);
+
+	unsigned long long end = offset + min(length, ~0ULL - offset);
+	unsigned long long recordOffset = position, blockStart = 0, firstLetter = 0;
+
+	while (valid && blockStart < end && offset < end) {
+
+		bufferType record, payload;
+		unsigned long long rawSize, payloadSize;
+		size_t recordPosition = 0;
+
+		valid = recordOffset <= fileSize
+				&& readRange(fd, recordOffset, min(fileSize - recordOffset, 9ULL),
+						record, backend)
+				&& readInteger(record, recordPosition, 4, rawSize);
+
+		if (!valid || rawSize == 0) {
+
+			break;
+
+		}
+
+		valid = readInteger(record, recordPosition, 4, payloadSize)
+				&& recordPosition < record.size()
+				&& recordOffset + 9 + payloadSize <= fileSize;
+
+		// blocks ending before the range are skipped without reading their payloads
+		if (valid && blockStart + rawSize > offset) {
+
+			if (letters.empty()) {
+
+				firstLetter = blockStart;
+
+			}
+
+			valid = readRange(fd, recordOffset + 9, payloadSize, payload, backend)
+					&& decodeBlock(payload.data(), payloadSize,
+							(BlockType) record[recordPosition], frontEnd, rawSize,
+							letters, &staticTable);
+
+		}
+
+		recordOffset += 9 + payloadSize;
+		blockStart += rawSize;
+
+	}
+
+	FileIO::closeFile(fd);
+
+	if (!valid) {
+
+		cout << "Corrupt compressed file: " << inputFileName << endl;
+		return false;
+
+	}
+
+	if (offset >= firstLetter) {
+
+		cutRange(letters, offset - firstLetter, length, output);
+
+	}
+
+	return true;
+
+}
@@ -0,0 +1,503 @@
+//=======================================================================================
+// Name        : HuffmanKernels.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+#include "ThreadPool.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HUFFMAN_X86
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HUFFMAN_LITTLE_ENDIAN
+#endif
+
+using namespace std;
+
+const unsigned int DPLKYL002::HuffmanTree::kernelThreshold;
+const unsigned int DPLKYL002::HuffmanTree::pairTableThreshold;
+const unsigned int DPLKYL002::HuffmanTree::encodeChunkSize;
+
+namespace {
+
+/*Collects bits in a 64-bit word and stores it 8 bytes at a time (little endian, so the
+  bytes come out in BitWriter order). Values may be up to 60 bits long.
+  */
+class WordWriter {
+public:
+
+	unsigned char * output;
+	unsigned long long bits;
+	unsigned int numBits; // always below 64
+
+	void write(unsigned long long value, unsigned int length) {
+
+		bits |= value << numBits;
+
+		if (numBits + length >= 64) {
+
+			memcpy(output, &bits, 8);
+			output += 8;
+
+			// length is at most 60, so numBits is not 0 here
+			bits = value >> (64 - numBits);
+			numBits = numBits + length - 64;
+
+		} else {
+
+			numBits += length;
+
+		}
+
+	}
+};
+
+// one letter at a time
+void encodeLetters(const unsigned char * data, size_t size,
+		const unsigned int * packedCodes, WordWriter & writer) {
+
+	for (size_t i = 0; i < size; i++) {
+
+		unsigned int packed = packedCodes[data[i]];
+		writer.write(packed & 0xFFFF, packed >> 16);
+
+	}
+
+}
+
+// two letters at a time, from a table of every letter pair (64K entries)
+void encodePairs(const unsigned char * data, size_t size,
+		const unsigned int * packedCodes, WordWriter & writer) {
+
+	vector<unsigned long long> pairs(1 << 16);
+
+	for (unsigned int second = 0; second < 256; second++) {
+
+		unsigned long long secondCode = packedCodes[second] & 0xFFFF;
+		unsigned int secondLength = packedCodes[second] >> 16;
+
+		for (unsigned int first = 0; first < 256; first++) {
+
+			unsigned int firstLength = packedCodes[first] >> 16;
+
+			// both codes in the low 32 bits, the total length above
+			pairs[first | (second << 8)] = ((packedCodes[first] & 0xFFFF)
+					| (secondCode << firstLength))
+					| ((unsigned long long) (firstLength + secondLength) << 32);
+
+		}
+
+	}
+
+	size_t i = 0;
+
+	for (; i + 2 <= size; i += 2) {
+
+		unsigned long long pair = pairs[data[i] | (data[i + 1] << 8)];
+		writer.write(pair & 0xFFFFFFFF, pair >> 32);
+
+	}
+
+	encodeLetters(data + i, size - i, packedCodes, writer);
+
+}
+
+#ifdef HUFFMAN_X86
+
+/*Eight letters at a time: their codes are gathered into 32-bit lanes, then joined in
+  pairs (64-bit lanes) and pairs of pairs (within each 128-bit half) by shifting each
+  code past the ones before it. Two values of at most 60 bits are left to write.
+  */
+__attribute__((target("avx2")))
+void encodeAvx2(const unsigned char * data, size_t size,
+		const unsigned int * packedCodes, WordWriter & writer) {
+
+	const __m256i codeMask = _mm256_set1_epi32(0xFFFF);
+	const __m256i lowHalf = _mm256_set1_epi64x(0xFFFFFFFF);
+
+	alignas(32) unsigned long long quads[4], quadLengths[4];
+
+	size_t i = 0;
+
+	for (; i + 8 <= size; i += 8) {
+
+		__m256i letters = _mm256_cvtepu8_epi32(
+				_mm_loadl_epi64((const __m128i *) (data + i)));
+		__m256i packed = _mm256_i32gather_epi32((const int *) packedCodes, letters,
+				4);
+
+		__m256i code = _mm256_and_si256(packed, codeMask);
+		__m256i length = _mm256_srli_epi32(packed, 16);
+
+		__m256i firstLength = _mm256_and_si256(length, lowHalf);
+		__m256i pair = _mm256_or_si256(_mm256_and_si256(code, lowHalf),
+				_mm256_sllv_epi64(_mm256_srli_epi64(code, 32), firstLength));
+		__m256i pairLength = _mm256_add_epi64(firstLength,
+				_mm256_srli_epi64(length, 32));
+
+		__m256i quad = _mm256_or_si256(pair,
+				_mm256_sllv_epi64(_mm256_srli_si256(pair, 8), pairLength));
+		__m256i quadLength = _mm256_add_epi64(pairLength,
+				_mm256_srli_si256(pairLength, 8));
+
+		_mm256_store_si256((__m256i *) quads, quad);
+		_mm256_store_si256((__m256i *) quadLengths, quadLength);
+
+		writer.write(quads[0], quadLengths[0]);
+		writer.write(quads[2], quadLengths[2]);
+
+	}
+
+	encodeLetters(data + i, size - i, packedCodes, writer);
+
+}
+
+#endif
+
+// runs the fastest encoder kernel this processor has
+void encodeKernel(const unsigned char * data, size_t size,
+		const unsigned int * packedCodes, WordWriter & writer) {
+
+#ifdef HUFFMAN_X86
+	if (DPLKYL002::HuffmanTree::simdSupported()) {
+
+		encodeAvx2(data, size, packedCodes, writer);
+
+	} else
+#endif
+	if (size >= DPLKYL002::HuffmanTree::pairTableThreshold) {
+
+		encodePairs(data, size, packedCodes, writer);
+
+	} else {
+
+		encodeLetters(data, size, packedCodes, writer);
+
+	}
+
+}
+
+// stores the whole bytes still in the word, leaving fewer than 8 bits
+void flushWholeBytes(WordWriter & writer) {
+
+	while (writer.numBits >= 8) {
+
+		*writer.output++ = (unsigned char) writer.bits;
+		writer.bits >>= 8;
+		writer.numBits -= 8;
+
+	}
+
+}
+
+/*Decodes from a 64-bit window while at least 8 bytes of data are left, several letters
+  per load. Stops at a code longer than the table (entry length 0) for the caller to
+  decode the slow way. Returns the number of letters decoded.
+  */
+size_t decodeWindow(const unsigned int * entries, unsigned int tableBits,
+		const unsigned char * data, size_t size, unsigned long long & position,
+		unsigned char * output, size_t count) {
+
+	const unsigned long long mask = (1ULL << tableBits) - 1;
+	size_t i = 0;
+
+	while (i < count && (position >> 3) + 8 <= size) {
+
+		unsigned long long window;
+		memcpy(&window, data + (position >> 3), 8);
+
+		unsigned int available = 64 - (position & 7);
+		window >>= position & 7;
+
+		while (i < count && available >= tableBits) {
+
+			unsigned int entry = entries[window & mask];
+			unsigned int length = entry & 0x1F;
+
+			if (length == 0) {
+
+				return i;
+
+			}
+
+			window >>= length;
+			available -= length;
+			position += length;
+			output[i++] = (unsigned char) (entry >> 5);
+
+		}
+
+	}
+
+	return i;
+
+}
+
+#ifdef HUFFMAN_X86
+
+// as decodeWindow, with the BMI2 bit extraction (bzhi; variable shifts become shrx)
+__attribute__((target("bmi2")))
+size_t decodeWindowBmi2(const unsigned int * entries, unsigned int tableBits,
+		const unsigned char * data, size_t size, unsigned long long & position,
+		unsigned char * output, size_t count) {
+
+	size_t i = 0;
+
+	while (i < count && (position >> 3) + 8 <= size) {
+
+		unsigned long long window;
+		memcpy(&window, data + (position >> 3), 8);
+
+		unsigned int available = 64 - (position & 7);
+		window >>= position & 7;
+
+		while (i < count && available >= tableBits) {
+
+			unsigned int entry = entries[_bzhi_u64(window, tableBits)];
+			unsigned int length = entry & 0x1F;
+
+			if (length == 0) {
+
+				return i;
+
+			}
+
+			window >>= length;
+			available -= length;
+			position += length;
+			output[i++] = (unsigned char) (entry >> 5);
+
+		}
+
+	}
+
+	return i;
+
+}
+
+#endif
+
+}
+
+bool DPLKYL002::HuffmanTree::bmi2Supported(void) {
+
+#ifdef HUFFMAN_X86
+	static const bool supported = __builtin_cpu_supports("bmi2");
+
+	return supported;
+#else
+	return false;
+#endif
+
+}
+
+// byte codes for the kernels: the (reversed) code in the low 16 bits, its length above
+void DPLKYL002::HuffmanTree::packCodes(const vector<unsigned int> & codes,
+		const vector<unsigned char> & codeLengths,
+		vector<unsigned int> & packedCodes) {
+
+	packedCodes.assign(256, 0);
+
+	for (unsigned int c = 0; c < 256 && c < codeLengths.size(); c++) {
+
+		packedCodes[c] = codes[c] | (codeLengths[c] << 16);
+
+	}
+
+}
+
+/*Writes the codes of data[0, size). Longer inputs go to a kernel picked for this
+  processor at run time: AVX2 (eight letters per step), then a letter pair table for
+  large inputs, then one letter at a time. All of them produce the same bits.
+  */
+void DPLKYL002::HuffmanTree::encodeSymbols(const unsigned char * data,
+		size_t size, const unsigned int * packedCodes, BitWriter & writer) {
+
+#ifdef HUFFMAN_LITTLE_ENDIAN
+	if (size >= kernelThreshold) {
+
+		WordWriter wordWriter;
+		bufferType & buffer = writer.getBuffer();
+		size_t start = buffer.size();
+
+		writer.takePendingBits(wordWriter.bits, wordWriter.numBits);
+
+		// codes are at most 15 bits, plus room for the last 8 byte store
+		buffer.resize(start + size * 2 + 16);
+		wordWriter.output = buffer.data() + start;
+
+		encodeKernel(data, size, packedCodes, wordWriter);
+		flushWholeBytes(wordWriter);
+
+		buffer.resize(wordWriter.output - buffer.data());
+		writer.writeBits((unsigned int) wordWriter.bits, wordWriter.numBits);
+
+		return;
+
+	}
+#endif
+
+	for (size_t i = 0; i < size; i++) {
+
+		unsigned int packed = packedCodes[data[i]];
+		writer.writeBits(packed & 0xFFFF, packed >> 16);
+
+	}
+
+}
+
+/*The same bits as encodeSymbols, written by up to numThreads tasks on the library's
+  thread pool. Each task first adds up the code lengths of its chunk of the letters; a
+  prefix sum of those gives the exact bit offset of every chunk, and each task then
+  writes its codes straight into the shared output from that offset. A task only stores
+  the whole bytes of its chunk (its first byte starts with zero bits where the previous
+  chunk ends); the bits left over in its last byte are merged in with OR once every task
+  has finished.
+  */
+void DPLKYL002::HuffmanTree::encodeSymbolsParallel(const unsigned char * data,
+		size_t size, const unsigned int * packedCodes, BitWriter & writer,
+		unsigned int numThreads) {
+
+	size_t numChunks = min((size_t) max(1u, numThreads), size / encodeChunkSize);
+
+#ifdef HUFFMAN_LITTLE_ENDIAN
+	if (numChunks > 1) {
+
+		vector<size_t> chunkStarts(numChunks + 1);
+
+		for (size_t c = 0; c <= numChunks; c++) {
+
+			chunkStarts[c] = size * c / numChunks;
+
+		}
+
+		// bit offset of each chunk, after the bits the writer is still holding
+		unsigned long long pendingBits;
+		unsigned int numPendingBits;
+
+		writer.takePendingBits(pendingBits, numPendingBits);
+
+		vector<unsigned long long> chunkOffsets(numChunks + 1, 0);
+		vector<WordWriter> tails(numChunks);
+		ThreadPool & threadPool = ThreadPool::shared();
+
+		auto countBits = [&](size_t c) {
+
+			unsigned long long bits = 0;
+
+			for (size_t i = chunkStarts[c]; i < chunkStarts[c + 1]; i++) {
+
+				bits += packedCodes[data[i]] >> 16;
+
+			}
+
+			chunkOffsets[c + 1] = bits;
+
+		};
+
+		threadPool.forEach(numChunks, countBits);
+
+		chunkOffsets[0] = numPendingBits;
+
+		for (size_t c = 1; c <= numChunks; c++) {
+
+			chunkOffsets[c] += chunkOffsets[c - 1];
+
+		}
+
+		unsigned long long totalBits = chunkOffsets[numChunks];
+		bufferType & buffer = writer.getBuffer();
+		size_t start = buffer.size();
+
+		// room for the last partial byte, which no thread stores
+		buffer.resize(start + totalBits / 8 + 1, 0);
+
+		unsigned char * output = buffer.data() + start;
+
+		auto encodeChunk = [&](size_t c) {
+
+			WordWriter & wordWriter = tails[c];
+
+			wordWriter.output = output + chunkOffsets[c] / 8;
+			wordWriter.bits = c == 0 ? pendingBits : 0;
+			wordWriter.numBits = chunkOffsets[c] % 8;
+
+			encodeKernel(data + chunkStarts[c], chunkStarts[c + 1] - chunkStarts[c],
+					packedCodes, wordWriter);
+			flushWholeBytes(wordWriter);
+
+		};
+
+		threadPool.forEach(numChunks, encodeChunk);
+
+		// the bytes shared by neighbouring chunks
+		for (const auto & tail : tails) {
+
+			*tail.output |= (unsigned char) tail.bits;
+
+		}
+
+		unsigned int lastByte = output[totalBits / 8];
+
+		buffer.resize(start + totalBits / 8);
+		writer.writeBits(lastByte, totalBits % 8);
+
+		return;
+
+	}
+#endif
+
+	encodeSymbols(data, size, packedCodes, writer);
+
+}
+
+// decodes count letters, using the BMI2 window decoder when the processor has it
+void DPLKYL002::HuffmanTree::decodeSymbols(const DecodeTable & table,
+		BitReader & reader, unsigned char * output, size_t count) {
+
+	size_t i = 0;
+
+	while (i < count) {
+
+#ifdef HUFFMAN_LITTLE_ENDIAN
+		unsigned long long position = reader.getPosition();
+
+#ifdef HUFFMAN_X86
+		if (bmi2Supported()) {
+
+			i += decodeWindowBmi2(table.getEntries(), table.getTableBits(),
+					reader.getData(), reader.getSize(), position, output + i,
+					count - i);
+
+		} else
+#endif
+		{
+
+			i += decodeWindow(table.getEntries(), table.getTableBits(),
+					reader.getData(), reader.getSize(), position, output + i,
+					count - i);
+
+		}
+
+		reader.setPosition(position);
+#endif
+
+		// a code longer than the table, or the last few bytes
+		if (i < count) {
+
+			output[i++] = (unsigned char) table.decode(reader);
+
+		}
+
+	}
+
+}
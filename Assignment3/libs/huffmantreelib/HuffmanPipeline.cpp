@@ -0,0 +1,297 @@
+//=======================================================================================
+// Name        : HuffmanPipeline.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+#include "BoundedQueue.h"
+#include "ThreadPool.h"
+
+#include <iostream>
+#include <fstream>
+
+using namespace std;
+
+const unsigned int DPLKYL002::HuffmanTree::pipelineBuffers;
+
+namespace {
+
+// one block buffer of the pipeline, reused for block after block
+class PipelineBlock {
+public:
+
+	size_t sequence; // position of the block in the file
+	DPLKYL002::HuffmanTree::bufferType input, output;
+
+};
+
+}
+
+/*Compresses a file in three overlapping stages: a reader thread reads it a block at a
+  time, the library's thread pool encodes the blocks, and the calling thread writes them
+  out in order. The stages pass block buffers through bounded queues and the writer hands
+  each buffer back to the reader once it is written, so disk and processor work at the
+  same time with a fixed number of blocks in memory. The container is the same one
+  compressBuffer writes with fixed size blocks.
+  */
+bool DPLKYL002::HuffmanTree::compressStream(string inputFileName,
+		string outputFileName, const Options & options) {
+
+	StaticTable staticTable;
+
+	// a trained table which can not be loaded fails the file, before anything is written
+	if (options.frontEnd == FRONT_END_TRAINED
+			&& !loadTable(options.tableDirectory, options.tableId, staticTable)) {
+
+		cout << "Unable to load table: "
+				<< tableFileName(options.tableDirectory, options.tableId) << endl;
+		return false;
+
+	}
+
+	FileIO::Backend backend = fileBackend(options);
+	bool useStreams = backend == FileIO::BACKEND_STREAMS;
+	ifstream inputFile;
+	ofstream outputFile;
+	int inputFd = -1, outputFd = -1;
+
+	if (useStreams) {
+
+		inputFile.open(inputFileName.c_str(), ios::binary);
+
+	} else {
+
+		inputFd = FileIO::openFile(inputFileName, false, options.directIO);
+
+	}
+
+	if (useStreams ? !inputFile : inputFd < 0) {
+
+		cout << "Unable to open: " << inputFileName << endl;
+		return false;
+
+	}
+
+	if (useStreams) {
+
+		outputFile.open(outputFileName.c_str(), ios::binary);
+
+	} else {
+
+		outputFd = FileIO::openFile(outputFileName, true, options.directIO);
+
+	}
+
+	if (useStreams ? !outputFile.is_open() : outputFd < 0) {
+
+		FileIO::closeFile(inputFd);
+		cout << "Unable to open: " << outputFileName << endl;
+		return false;
+
+	}
+
+	unsigned long long readOffset = 0, writeOffset = 0;
+	bool readFailed = false, writeFailed = false;
+
+	// with O_DIRECT, blocks go through aligned staging buffers of their own
+	unique_ptr<FileIO::DirectReader> directReader;
+	unique_ptr<FileIO::DirectWriter> directWriter;
+
+	if (options.directIO) {
+
+		directReader.reset(
+				new FileIO::DirectReader(inputFd, backend, FileIO::directBufferSize,
+						options.hugePages));
+		directWriter.reset(
+				new FileIO::DirectWriter(outputFd, backend, FileIO::directBufferSize,
+						options.hugePages));
+
+	}
+
+	// the next blockSize bytes of the input, fewer at the end of the file
+	auto readBlock = [&](bufferType & input, size_t blockSize) {
+
+		input.resize(blockSize);
+
+		if (useStreams) {
+
+			inputFile.read((char *) input.data(), blockSize);
+			input.resize(inputFile.gcount());
+			return;
+
+		}
+
+		long long numRead = directReader ?
+				directReader->read(input.data(), blockSize) :
+				FileIO::readAt(inputFd, input.data(), blockSize, readOffset, backend);
+
+		readFailed = readFailed || numRead < 0;
+		input.resize(max(0ll, numRead));
+		readOffset += input.size();
+
+	};
+
+	auto writeBytes = [&](const bufferType & output) {
+
+		if (useStreams) {
+
+			outputFile.write((const char *) output.data(), output.size());
+			return;
+
+		}
+
+		if (directWriter) {
+
+			writeFailed = writeFailed
+					|| !directWriter->write(output.data(), output.size());
+			return;
+
+		}
+
+		writeFailed = writeFailed
+				|| FileIO::writeAt(outputFd, output.data(), output.size(),
+						writeOffset, backend) != (long long) output.size();
+		writeOffset += output.size();
+
+	};
+
+	Options blockOptions(options);
+
+	size_t blockSize = max(1u, blockOptions.blockSize);
+	size_t numEncoders = max(1u, blockOptions.threads);
+	bufferType header;
+
+	appendContainerHeader(header, blockOptions.frontEnd);
+
+	if (blockOptions.frontEnd == FRONT_END_TRAINED) {
+
+		appendInteger(header, staticTable.id, 4);
+
+	}
+
+	appendInteger(header, blockSize, 4);
+	writeBytes(header);
+
+	// blocks are encoded side by side, so a block is not split any further
+	blockOptions.threads = 1;
+
+	vector<PipelineBlock> blocks(numEncoders * pipelineBuffers + 2);
+	BoundedQueue<size_t> freeBlocks(blocks.size()), encodedBlocks(blocks.size());
+
+	for (size_t b = 0; b < blocks.size(); b++) {
+
+		freeBlocks.push(b);
+
+	}
+
+	// each block read becomes a task of the library's thread pool
+	thread reader([&]() {
+
+		ThreadPool & threadPool = ThreadPool::shared();
+		ThreadPool::TaskGroup encoding;
+		size_t b;
+
+		for (size_t sequence = 0; freeBlocks.pop(b); sequence++) {
+
+			PipelineBlock & block = blocks[b];
+
+			block.sequence = sequence;
+			readBlock(block.input, blockSize);
+
+			if (block.input.empty()) {
+
+				break;
+
+			}
+
+			// encodedBlocks has room for every block, so the task never waits
+			threadPool.submit(encoding, [&, b]() {
+
+				PipelineBlock & block = blocks[b];
+				HuffmanTree tree;
+
+				block.output.clear();
+				tree.encodeBlock(block.input.data(), block.input.size(),
+						blockOptions, block.output, &staticTable);
+				encodedBlocks.push(b);
+
+			});
+
+			if (block.input.size() < blockSize) {
+
+				break;
+
+			}
+
+		}
+
+		threadPool.wait(encoding);
+		encodedBlocks.close();
+
+	});
+
+	// blocks finish out of order; each waits here until the blocks before it are written
+	unordered_map<size_t, size_t> finished;
+	size_t nextSequence = 0, b;
+
+	while (encodedBlocks.pop(b)) {
+
+		finished[blocks[b].sequence] = b;
+
+		for (auto next = finished.find(nextSequence); next != finished.end();
+				next = finished.find(nextSequence)) {
+
+			writeBytes(blocks[next->second].output);
+			freeBlocks.push(next->second);
+			finished.erase(next);
+			nextSequence++;
+
+		}
+
+	}
+
+	freeBlocks.close();
+	reader.join();
+
+	bufferType end;
+	appendInteger(end, 0, 4); // end of blocks
+
+	writeBytes(end);
+
+	if (directWriter && !directWriter->finish()) {
+
+		writeFailed = true;
+
+	}
+
+	if (useStreams) {
+
+		outputFile.close();
+		writeFailed = !outputFile;
+
+	}
+
+	FileIO::closeFile(inputFd);
+	FileIO::closeFile(outputFd);
+
+	if (readFailed) {
+
+		cout << "Unable to read: " << inputFileName << endl;
+		return false;
+
+	}
+
+	if (writeFailed) {
+
+		cout << "Unable to write: " << outputFileName << endl;
+		return false;
+
+	}
+
+	return true;
+
+}
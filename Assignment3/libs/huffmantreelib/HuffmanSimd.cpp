@@ -0,0 +1,260 @@
+//=======================================================================================
+// Name        : HuffmanSimd.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+
+#include <algorithm>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HUFFMAN_X86
+#endif
+
+using namespace std;
+
+const unsigned int DPLKYL002::HuffmanTree::numLanes;
+
+namespace {
+
+// padding after each record in the lane buffer, so a 4 byte load never leaves it
+const unsigned int lanePadding = 8;
+
+#ifdef HUFFMAN_X86
+
+/*Decodes up to 8 records at once, one per 32-bit lane. Each step gathers the next 4 bytes
+  of every record, then gathers the table entries they index. Lanes whose record is
+  finished stop advancing. Loads are clamped to the end of each record (plus padding), so
+  corrupt data can not read outside the lane buffer; the bit positions are checked after.
+  */
+__attribute__((target("avx2")))
+bool decodeLanesAvx2(const unsigned int * entries, unsigned int tableBits,
+		const unsigned char * laneBuffer, const unsigned int * startBits,
+		const unsigned int * endBits, const unsigned int * rawSizes,
+		unsigned char * const * letters, unsigned int maxRawSize) {
+
+	__m256i bitPosition = _mm256_loadu_si256((const __m256i *) startBits);
+	const __m256i end = _mm256_loadu_si256((const __m256i *) endBits);
+	const __m256i remaining = _mm256_loadu_si256((const __m256i *) rawSizes);
+	const __m256i indexMask = _mm256_set1_epi32((1u << tableBits) - 1);
+	const __m256i lengthMask = _mm256_set1_epi32(0x1F);
+	const __m256i seven = _mm256_set1_epi32(7);
+	__m256i invalid = _mm256_setzero_si256();
+
+	alignas(32) unsigned int symbols[8];
+
+	for (unsigned int i = 0; i < maxRawSize; i++) {
+
+		__m256i active = _mm256_cmpgt_epi32(remaining, _mm256_set1_epi32(i));
+		__m256i position = _mm256_min_epu32(bitPosition, end);
+
+		__m256i word = _mm256_i32gather_epi32((const int *) laneBuffer,
+				_mm256_srli_epi32(position, 3), 1);
+		__m256i index = _mm256_and_si256(
+				_mm256_srlv_epi32(word, _mm256_and_si256(position, seven)),
+				indexMask);
+		__m256i entry = _mm256_i32gather_epi32((const int *) entries, index, 4);
+
+		__m256i length = _mm256_and_si256(_mm256_and_si256(entry, lengthMask),
+				active);
+
+		// an active lane with no table entry has hit a code that is not in the table
+		invalid = _mm256_or_si256(invalid,
+				_mm256_and_si256(active,
+						_mm256_cmpeq_epi32(length, _mm256_setzero_si256())));
+		bitPosition = _mm256_add_epi32(bitPosition, length);
+
+		_mm256_store_si256((__m256i *) symbols, _mm256_srli_epi32(entry, 5));
+
+		for (unsigned int lane = 0; lane < 8; lane++) {
+
+			if (i < rawSizes[lane]) {
+
+				letters[lane][i] = (unsigned char) symbols[lane];
+
+			}
+
+		}
+
+	}
+
+	// no lane may have read past the end of its record
+	__m256i overrun = _mm256_cmpgt_epi32(bitPosition, end);
+
+	return _mm256_testz_si256(_mm256_or_si256(invalid, overrun),
+			_mm256_or_si256(invalid, overrun));
+
+}
+
+#endif
+
+}
+
+bool DPLKYL002::HuffmanTree::simdSupported(void) {
+
+#ifdef HUFFMAN_X86
+	static const bool supported = __builtin_cpu_supports("avx2");
+
+	return supported;
+#else
+	return false;
+#endif
+
+}
+
+/*Decodes records [first, last) of a batch. Records are taken in order of size, so each
+  group of lanes holds records of about the same length and few lanes sit idle.
+  */
+bool DPLKYL002::HuffmanTree::decodeRecords(const DecodeTable & table,
+		const vector<Span> & inputs, vector<bufferType> & outputs, size_t first,
+		size_t last) {
+
+	bool valid = true;
+
+	if (!simdSupported() || !table.isSingleLookup()) {
+
+		for (size_t r = first; r < last; r++) {
+
+			outputs[r].clear();
+			valid = decodeRecord(table, inputs[r].data, inputs[r].size, outputs[r])
+					&& valid;
+
+		}
+
+		return valid;
+
+	}
+
+	vector<size_t> order(last - first);
+	iota(order.begin(), order.end(), first);
+
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+
+		return inputs[a].size < inputs[b].size;
+
+	});
+
+	Span records[numLanes];
+	bufferType * laneOutputs[numLanes];
+
+	for (size_t g = 0; g < order.size(); g += numLanes) {
+
+		unsigned int numRecords = min((size_t) numLanes, order.size() - g);
+
+		for (unsigned int lane = 0; lane < numRecords; lane++) {
+
+			records[lane] = inputs[order[g + lane]];
+			laneOutputs[lane] = &outputs[order[g + lane]];
+
+		}
+
+		valid = decodeRecordLanes(table, records, laneOutputs, numRecords)
+				&& valid;
+
+	}
+
+	return valid;
+
+}
+
+// decodes up to numLanes records side by side, falling back to one at a time
+bool DPLKYL002::HuffmanTree::decodeRecordLanes(const DecodeTable & table,
+		const Span * records, bufferType * const * outputs,
+		unsigned int numRecords) {
+
+	auto decodeOneByOne = [&]() {
+
+		bool valid = true;
+
+		for (unsigned int lane = 0; lane < numRecords; lane++) {
+
+			outputs[lane]->clear();
+			valid = decodeRecord(table, records[lane].data, records[lane].size,
+					*outputs[lane]) && valid;
+
+		}
+
+		return valid;
+
+	};
+
+#ifdef HUFFMAN_X86
+	if (!simdSupported() || !table.isSingleLookup() || numRecords > numLanes) {
+
+		return decodeOneByOne();
+
+	}
+
+	unsigned int startBits[numLanes] = { 0 }, endBits[numLanes] = { 0 },
+			rawSizes[numLanes] = { 0 };
+	unsigned char * letters[numLanes];
+	unsigned int maxRawSize = 0;
+	size_t laneBufferSize = 0;
+	size_t payloadStarts[numLanes];
+
+	// read the letter counts; lane positions are 32-bit bit offsets into the lane buffer
+	for (unsigned int lane = 0; lane < numRecords; lane++) {
+
+		size_t position = 0;
+		unsigned long long rawSize;
+
+		if (!readVarint(records[lane].data, records[lane].size, position, rawSize)
+				|| rawSize > (records[lane].size - position) * 8
+				|| rawSize > 0x7FFFFFFF) {
+
+			return decodeOneByOne();
+
+		}
+
+		payloadStarts[lane] = position;
+		rawSizes[lane] = rawSize;
+		startBits[lane] = laneBufferSize * 8;
+		laneBufferSize += records[lane].size - position;
+		endBits[lane] = laneBufferSize * 8;
+		laneBufferSize += lanePadding;
+		maxRawSize = max(maxRawSize, rawSizes[lane]);
+
+		if (laneBufferSize >= (1u << 24)) {
+
+			return decodeOneByOne();
+
+		}
+
+	}
+
+	bufferType laneBuffer(laneBufferSize + lanePadding, 0);
+	bufferType unused(1);
+
+	for (unsigned int lane = 0; lane < numLanes; lane++) {
+
+		if (lane >= numRecords) {
+
+			// idle lanes decode nothing from an empty record
+			startBits[lane] = endBits[lane] = laneBufferSize * 8;
+			letters[lane] = unused.data();
+			continue;
+
+		}
+
+		copy(records[lane].data + payloadStarts[lane],
+				records[lane].data + records[lane].size,
+				laneBuffer.begin() + startBits[lane] / 8);
+
+		outputs[lane]->assign(rawSizes[lane], 0);
+		letters[lane] = outputs[lane]->data();
+
+	}
+
+	return decodeLanesAvx2(table.getEntries(), table.getTableBits(),
+			laneBuffer.data(), startBits, endBits, rawSizes, letters, maxRawSize);
+#else
+	return decodeOneByOne();
+#endif
+
+}
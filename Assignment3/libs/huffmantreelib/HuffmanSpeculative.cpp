@@ -0,0 +1,268 @@
+//=======================================================================================
+// Name        : HuffmanSpeculative.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+const unsigned int DPLKYL002::HuffmanTree::speculativeChunkBits;
+const unsigned int DPLKYL002::HuffmanTree::speculativeCodeStarts;
+
+namespace {
+
+/*Decodes the code starting at position, stopping at numBits. Returns false if the bits
+  are not a code (or the stream ends inside one).
+  */
+inline bool decodeLegacyCode(const vector<int> & links, const unsigned char * data,
+		unsigned long long numBits, unsigned long long & position,
+		unsigned char & letter) {
+
+	unsigned int node = 0;
+
+	while (position < numBits) {
+
+		unsigned int bit = (data[position >> 3] >> (7 - (position & 7))) & 1;
+		int link = links[2 * node + bit];
+
+		position++;
+
+		if (link < 0) {
+
+			letter = (unsigned char) (-link - 1);
+			return true;
+
+		}
+
+		if (link == 0) {
+
+			return false;
+
+		}
+
+		node = link;
+
+	}
+
+	return false;
+
+}
+
+// what one task decoded from the start of its chunk
+class Chunk {
+public:
+
+	unsigned long long begin, end;
+	unsigned long long exit; // where the decode left the chunk (or hit an invalid code)
+	bool valid; // false if the decode hit bits that are not a code
+	vector<unsigned long long> codeStarts; // only the first speculativeCodeStarts
+	string letters; // letters[i] is the code starting at codeStarts[i]
+
+};
+
+// decodes every code starting in [chunk.begin, chunk.end)
+void decodeChunk(const vector<int> & links, const unsigned char * data,
+		unsigned long long numBits, Chunk & chunk, bool recordStarts) {
+
+	unsigned long long position = chunk.begin;
+	unsigned char letter;
+
+	chunk.valid = true;
+
+	while (position < chunk.end) {
+
+		unsigned long long start = position;
+
+		if (!decodeLegacyCode(links, data, numBits, position, letter)) {
+
+			chunk.valid = false;
+			position = start;
+			break;
+
+		}
+
+		// the true stream normally meets one of the first few dozen codes
+		if (recordStarts
+				&& chunk.codeStarts.size()
+						< DPLKYL002::HuffmanTree::speculativeCodeStarts) {
+
+			chunk.codeStarts.push_back(start);
+
+		}
+
+		chunk.letters += (char) letter;
+
+	}
+
+	chunk.exit = position;
+
+}
+
+}
+
+/*The legacy code table as a binary tree in an array: links[2 * node + bit] is the next
+  node, -1 - letter for a leaf, or 0 where no code continues (node 0 is the root, so it is
+  never a link). Codes which are a prefix of another code end at the shorter one, as they
+  did when the bit string was matched against the table one bit at a time.
+  */
+void DPLKYL002::HuffmanTree::buildLegacyCode(
+		const unordered_map<string, string> & map, vector<int> & links) {
+
+	links.assign(2, 0);
+
+	for (const auto & field : map) {
+
+		const string & code = field.first;
+
+		if (code.empty() || field.second.empty()) {
+
+			continue;
+
+		}
+
+		unsigned int node = 0;
+
+		for (size_t i = 0; i < code.size(); i++) {
+
+			int & link = links[2 * node + (code[i] == '1' ? 1 : 0)];
+
+			if (link < 0) {
+
+				break; // a shorter code already ends here
+
+			}
+
+			if (i + 1 == code.size()) {
+
+				link = -1 - (unsigned char) field.second[0];
+				break;
+
+			}
+
+			if (link == 0) {
+
+				link = links.size() / 2;
+				links.resize(links.size() + 2, 0);
+
+			}
+
+			node = links[2 * node + (code[i] == '1' ? 1 : 0)];
+
+		}
+
+	}
+
+}
+
+/*Decodes numBits bits of a legacy .bin stream in up to numThreads pool tasks. The stream
+  has no index, so every task but the first starts at an arbitrary bit of its chunk and
+  records where its first codes start. Huffman codes soon fall back into step with the
+  true stream, so once the true decode of the chunks before reaches one of those code
+  starts, the rest of that chunk's letters are right; only the few codes before that point
+  are decoded again. A chunk which does not fall into step within its recorded codes is
+  decoded again serially.
+  */
+void DPLKYL002::HuffmanTree::decodeLegacyStream(const vector<int> & links,
+		const unsigned char * data, unsigned long long numBits, string & output,
+		unsigned int numThreads) {
+
+	size_t numChunks = min((unsigned long long) max(1u, numThreads),
+			max(1ull, numBits / speculativeChunkBits));
+
+	vector<Chunk> chunks(numChunks);
+
+	for (size_t c = 0; c < numChunks; c++) {
+
+		chunks[c].begin = numBits * c / numChunks;
+		chunks[c].end = numBits * (c + 1) / numChunks;
+
+	}
+
+	// the first chunk starts on a code, so it is decoded for real
+	ThreadPool::shared().forEach(numChunks, [&](size_t c) {
+
+		decodeChunk(links, data, numBits, chunks[c], c > 0);
+
+	});
+
+	output += chunks[0].letters;
+
+	unsigned long long position = chunks[0].exit;
+	bool valid = chunks[0].valid;
+
+	for (size_t c = 1; c < numChunks && valid; c++) {
+
+		Chunk & chunk = chunks[c];
+		size_t next = 0;
+
+		// decode for real until the true stream meets a code this chunk started on
+		while (position < chunk.end) {
+
+			while (next < chunk.codeStarts.size()
+					&& chunk.codeStarts[next] < position) {
+
+				next++;
+
+			}
+
+			if (next < chunk.codeStarts.size()
+					&& chunk.codeStarts[next] == position) {
+
+				output.append(chunk.letters, next, string::npos);
+				position = chunk.exit;
+				valid = chunk.valid;
+				break;
+
+			}
+
+			unsigned char letter;
+
+			if (!decodeLegacyCode(links, data, numBits, position, letter)) {
+
+				valid = false;
+				break;
+
+			}
+
+			output += (char) letter;
+
+		}
+
+	}
+
+}
+
+/*Decodes up to count letters from position (which must be the start of a code), adding
+  them to output if it is not null, so the letters before a range can be skipped. Returns
+  the number of letters decoded; fewer than count if the stream ends or the bits are not a
+  code.
+  */
+size_t DPLKYL002::HuffmanTree::decodeLegacyLetters(const vector<int> & links,
+		const unsigned char * data, unsigned long long numBits,
+		unsigned long long & position, size_t count, string * output) {
+
+	size_t numLetters = 0;
+	unsigned char letter;
+
+	while (numLetters < count
+			&& decodeLegacyCode(links, data, numBits, position, letter)) {
+
+		if (output) {
+
+			*output += (char) letter;
+
+		}
+
+		numLetters++;
+
+	}
+
+	return numLetters;
+
+}
@@ -0,0 +1,234 @@
+//=======================================================================================
+// Name        : HuffmanTables.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "HuffmanTree.h"
+#include "EnglishModel.h"
+
+#include <iostream>
+#include <cstdio>
+
+using namespace std;
+
+const unsigned int DPLKYL002::EnglishModel::maxCodeLength;
+
+constexpr DPLKYL002::EnglishModel::Code DPLKYL002::EnglishModel::code =
+		DPLKYL002::EnglishModel::buildCode();
+
+static_assert(DPLKYL002::EnglishModel::code.codeLengths[' '] > 0
+		&& DPLKYL002::EnglishModel::code.codeLengths[0] > 0,
+		"the English model must code every letter");
+
+/*Builds a code from the letter frequencies of a corpus of sample files and saves it in
+  tableDirectory. Every byte value gets a code (the frequencies start at 1), so the table
+  can code any input. Returns the table ID (0 if a corpus file could not be read).
+  */
+unsigned int DPLKYL002::HuffmanTree::trainTable(
+		const vector<string> & corpusFileNames, string tableDirectory) {
+
+	vector<unsigned int> frequencies(256, 1);
+	bufferType sample;
+
+	for (const auto & fileName : corpusFileNames) {
+
+		if (!readFile(fileName, sample)) {
+
+			return 0;
+
+		}
+
+		for (unsigned char letter : sample) {
+
+			if (frequencies[letter] < 0xFFFFFFFF) {
+
+				frequencies[letter]++;
+
+			}
+
+		}
+
+	}
+
+	vector<unsigned char> codeLengths;
+	buildCodeLengths(frequencies, codeLengths);
+
+	unsigned int tableId = tableIdentifier(codeLengths);
+
+	// table file: magic, version, then the code lengths
+	const char magic[] = "DPLT";
+	bufferType table(magic, magic + 4);
+
+	table.push_back(1);
+
+	BitWriter writer(table);
+	writeCodeLengths(writer, codeLengths);
+	writer.flush();
+
+	if (!writeFile(tableFileName(tableDirectory, tableId), table)) {
+
+		return 0;
+
+	}
+
+	return tableId;
+
+}
+
+// FNV-1a hash of the code lengths; 0 is kept for "no table"
+unsigned int DPLKYL002::HuffmanTree::tableIdentifier(
+		const vector<unsigned char> & codeLengths) {
+
+	unsigned int hash = 2166136261u;
+
+	for (unsigned char length : codeLengths) {
+
+		hash = (hash ^ length) * 16777619u;
+
+	}
+
+	return hash == 0 ? 1 : hash;
+
+}
+
+string DPLKYL002::HuffmanTree::tableFileName(string tableDirectory,
+		unsigned int tableId) {
+
+	char name[16];
+	snprintf(name, sizeof(name), "%08x.tbl", tableId);
+
+	return tableDirectory + "/" + name;
+
+}
+
+bool DPLKYL002::HuffmanTree::loadTable(string tableDirectory,
+		unsigned int tableId, StaticTable & staticTable) {
+
+	bufferType table;
+
+	if (!readFile(tableFileName(tableDirectory, tableId), table)) {
+
+		return false;
+
+	}
+
+	if (table.size() < 5 || string(table.begin(), table.begin() + 4) != "DPLT"
+			|| table[4] != 1) {
+
+		return false;
+
+	}
+
+	BitReader reader(table.data() + 5, table.size() - 5);
+
+	if (!readCodeLengths(reader, staticTable.codeLengths)
+			|| staticTable.codeLengths.size() != 256
+			|| tableIdentifier(staticTable.codeLengths) != tableId
+			|| find(staticTable.codeLengths.begin(),
+					staticTable.codeLengths.end(), 0)
+					!= staticTable.codeLengths.end()
+			|| !(staticTable.decodeTable = findDecodeTable(
+					staticTable.codeLengths))) {
+
+		return false;
+
+	}
+
+	staticTable.id = tableId;
+	buildCanonicalCodes(staticTable.codeLengths, staticTable.codes);
+	packCodes(staticTable.codes, staticTable.codeLengths, staticTable.packedCodes);
+
+	return true;
+
+}
+
+// static blocks are the codes alone - the code lengths come from the trained table
+void DPLKYL002::HuffmanTree::encodeStatic(const unsigned char * data,
+		size_t size, const StaticTable & staticTable, bufferType & payload,
+		unsigned int threads) {
+
+	BitWriter writer(payload);
+	encodeSymbolsParallel(data, size, staticTable.packedCodes.data(), writer,
+			threads);
+	writer.flush();
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeStatic(const unsigned char * payload,
+		size_t payloadSize, size_t rawSize, const StaticTable & staticTable,
+		bufferType & output) {
+
+	BitReader reader(payload, payloadSize);
+
+	size_t outputStart = output.size();
+	output.resize(outputStart + rawSize);
+
+	decodeSymbols(*staticTable.decodeTable, reader, output.data() + outputStart,
+			rawSize);
+
+	return !reader.overrun();
+
+}
+
+/*Tiny messages with the built-in English model: no container header and no code table,
+  just the letter count as a varint followed by the codes.
+  */
+void DPLKYL002::HuffmanTree::encodeEnglish(const unsigned char * data,
+		size_t size, bufferType & output) {
+
+	const EnglishModel::Code & model = EnglishModel::code;
+
+	appendVarint(output, size);
+
+	BitWriter writer(output);
+
+	for (size_t i = 0; i < size; i++) {
+
+		writer.writeBits(model.codes[data[i]], model.codeLengths[data[i]]);
+
+	}
+
+	writer.flush();
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeEnglish(const unsigned char * data,
+		size_t size, bufferType & output) {
+
+	const EnglishModel::Code & model = EnglishModel::code;
+
+	size_t position = 0;
+	unsigned long long rawSize;
+
+	// every letter takes at least one bit
+	if (!readVarint(data, size, position, rawSize)
+			|| rawSize > (size - position) * 8) {
+
+		return false;
+
+	}
+
+	BitReader reader(data + position, size - position);
+
+	size_t outputStart = output.size();
+	output.resize(outputStart + rawSize);
+
+	unsigned char * letter = output.data() + outputStart;
+
+	for (size_t i = 0; i < rawSize; i++) {
+
+		unsigned int entry = model.entries[reader.peekBits(
+				EnglishModel::maxCodeLength)];
+
+		reader.skipBits(entry & 0xF);
+		letter[i] = (unsigned char) (entry >> 4);
+
+	}
+
+	return !reader.overrun();
+
+}
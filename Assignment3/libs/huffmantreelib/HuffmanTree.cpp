@@ -9,15 +9,25 @@
 
 #include "HuffmanTree.h"
 
-#include <bitset>
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdio>
 
 using namespace std;
 
-void DPLKYL002::HuffmanTree::compress(string inputFileName,
-		string outputFileName) {
+const unsigned int DPLKYL002::HuffmanTree::maxCodeLength;
+const unsigned int DPLKYL002::HuffmanTree::numRunClasses;
+const unsigned int DPLKYL002::HuffmanTree::DecodeTable::invalidSymbol;
+const unsigned int DPLKYL002::HuffmanTree::DecodeTable::lookupBits;
+
+DPLKYL002::HuffmanTree::DecodeTableCache DPLKYL002::HuffmanTree::decodeTableCache;
+
+bool DPLKYL002::HuffmanTree::compress(string inputFileName,
+		string outputFileName, const Options & options) {
 
 	typedef HuffmanTree::HuffmanNode nodeType;
 	HuffmanTree tree;
@@ -27,37 +37,76 @@ void DPLKYL002::HuffmanTree::compress(string inputFileName,
 
 	priority_queue<nodeType, vector<nodeType>, HuffmanTree::Compare> priorityQueue;
 
-	tree.createMap(map, inputFileName);
-	tree.createPriorityQueue(priorityQueue, map);
+	if (!tree.createMap(map, inputFileName, options)) {
+
+		return false;
+
+	}
+
+	// an empty file has no tree, so its code table and bit stream are empty too
+	if (!map.empty()) {
+
+		tree.createPriorityQueue(priorityQueue, map);
+
+		HuffmanTree::HuffmanNode node(tree.buildHuffmanTree(priorityQueue));
+		tree.buildCodeTable(node, codeTableMap, "");
+
+	}
 
-	HuffmanTree::HuffmanNode node(tree.buildHuffmanTree(priorityQueue));
-	tree.buildCodeTable(node, codeTableMap, "");
 	tree.createCodeTableFile(outputFileName, codeTableMap);
 
-	string bitStringCode = tree.getBitStringCode(inputFileName, codeTableMap);
-	tree.createCompressedInputFile(outputFileName, bitStringCode);
-	tree.createBinaryFile(outputFileName, bitStringCode);
+	vector<unsigned long long> syncPoints;
+
+	string bitStringCode = tree.getBitStringCode(inputFileName, codeTableMap,
+			options, &syncPoints);
+
+	if (!tree.createCompressedInputFile(outputFileName, bitStringCode, options)
+			|| !tree.createBinaryFile(outputFileName, bitStringCode, options)) {
+
+		return false;
+
+	}
+
+	if (options.syncInterval > 0) {
+
+		unsigned long long numLetters = 0;
+
+		for (const auto &node : map) {
+
+			numLetters += node.second;
+
+		}
+
+		tree.createIndexFile(outputFileName, syncPoints, numLetters,
+				options.syncInterval, options);
+
+	} else {
+
+		// an index left from an earlier compression would no longer match
+		remove((outputFileName + indexExtension).c_str());
+
+	}
+
+	return true;
 
 }
 
-void DPLKYL002::HuffmanTree::createMap(HuffmanTree::mapType map,
-		string inputFileName) {
+bool DPLKYL002::HuffmanTree::createMap(HuffmanTree::mapType map,
+		string inputFileName, const Options & options) {
 
 	// create a map to store <key / letter, value / frequency> elements
 
-	ifstream inputFile(inputFileName.c_str());
-
-	if (!inputFile) {
+	bufferType input;
 
-		cout << "Unable to open: " << inputFileName << endl;
+	if (!readFile(inputFileName, input, options)) {
 
-		return;
+		return false;
 
 	}
 
-	char letter;
+	for (unsigned char byte : input) {
 
-	while (inputFile.get(letter)) {
+		char letter = byte;
 
 		// if new letter, add to map
 		if (map.find(letter) == map.end()) {
@@ -74,7 +123,8 @@ void DPLKYL002::HuffmanTree::createMap(HuffmanTree::mapType map,
 
 	}
 
-	inputFile.close();
+
+	return true;
 
 }
 
@@ -147,7 +197,8 @@ void DPLKYL002::HuffmanTree::buildCodeTable(nodeType node, codeType map,
 	// if leaf node encountered, add to map
 	if (node.leftLink == nullptr) {
 
-		map.insert( { node.getLetter(), bitStringCode });
+		// a tree with a single letter still needs a one bit code for that letter
+		map.insert( { node.getLetter(), bitStringCode == "" ? "0" : bitStringCode });
 		return;
 
 	}
@@ -192,7 +243,8 @@ void DPLKYL002::HuffmanTree::createCodeTableFile(string outputFileName,
 }
 
 string DPLKYL002::HuffmanTree::getBitStringCode(string inputFileName,
-		codeType map) {
+		codeType map, const Options & options,
+		vector<unsigned long long> * syncPoints) {
 
 	/*To compress your ASCII text file, take each character, in turn,
 	 finding its bit string code and write this into the output buffer.
@@ -200,57 +252,62 @@ string DPLKYL002::HuffmanTree::getBitStringCode(string inputFileName,
 	 append characters/strings to.
 	 */
 
-	ifstream inputFile(inputFileName.c_str());
+	bufferType input;
 
-	if (!inputFile) {
+	if (!readFile(inputFileName, input, options)) {
 
-		cout << "Unable to open: " << inputFileName << endl;
 		return "";
 
 	}
 
 	string bitStringCode;
-	char letter;
 
-	while (inputFile.get(letter)) {
+	// note where every syncInterval'th letter starts
+	unsigned int syncInterval = syncPoints ? options.syncInterval : 0;
 
-		bitStringCode += map[letter];
+	for (size_t k = 0; k < input.size(); k++) {
 
-	}
+		if (syncInterval > 0 && k % syncInterval == 0) {
 
-	inputFile.close();
+			syncPoints->push_back(bitStringCode.size());
+
+		}
+
+		bitStringCode += map[(char) input[k]];
+
+	}
 
 	return bitStringCode;
 
 }
 
 // output file (compressed input file)
-void DPLKYL002::HuffmanTree::createCompressedInputFile(string outputFileName,
-		string bitStringCode) {
+bool DPLKYL002::HuffmanTree::createCompressedInputFile(string outputFileName,
+		string bitStringCode, const Options & options) {
 
 	// create the compressed input English (ASCII) text file
-	ofstream outputFile(outputFileName.c_str());
 
-	if (outputFile.is_open()) {
-
-		/*first line - bit string code length
-		  second line - bit string code
-		  */
+	/*first line - bit string code length
+	  second line - bit string code
+	  */
 
-		outputFile << bitStringCode.size(); // bit string code length
-		outputFile << endl;
-		outputFile << bitStringCode; // bit string code
+	string bitStringCodeLength = to_string(bitStringCode.size()) + "\n";
+	bufferType outputFile;
 
-		outputFile.close();
+	outputFile.reserve(bitStringCodeLength.size() + bitStringCode.size());
+	outputFile.insert(outputFile.end(), bitStringCodeLength.begin(),
+			bitStringCodeLength.end()); // bit string code length
+	outputFile.insert(outputFile.end(), bitStringCode.begin(),
+			bitStringCode.end()); // bit string code
 
-	}
+	return writeFile(outputFileName, outputFile, options);
 
 }
 
 // extra credit (convert to bit stream)
 // output file (binary file)
-void DPLKYL002::HuffmanTree::createBinaryFile(string outputFileName,
-		string bitStringCode) {
+bool DPLKYL002::HuffmanTree::createBinaryFile(string outputFileName,
+		string bitStringCode, const Options & options) {
 
 	/*Convert your bits into an actual bit stream and store
 	  this in a byte array that is large enough; this should be written to disk as a binary
@@ -258,58 +315,66 @@ void DPLKYL002::HuffmanTree::createBinaryFile(string outputFileName,
 	  work out number of bytes to read from this.
 	  */
 
-	ofstream outputFile((outputFileName + ".bin").c_str(), ios::binary);
-
 	const unsigned char * letter =
 			(const unsigned char *) bitStringCode.c_str();
 
-	if (outputFile.is_open()) {
-
-		int bitStringCodeLength = bitStringCode.size(); // bit string code length
-
-		char endBitStringCode = '\n'; // end of bit string code
-
-		outputFile.write(reinterpret_cast<const char *>(&bitStringCodeLength),
-				sizeof(int));
+	int bitStringCodeLength = bitStringCode.size(); // bit string code length
 
-		outputFile.write(&endBitStringCode, 1);
+	char endBitStringCode = '\n'; // end of bit string code
 
-		// convert bits into an actual bit stream
-		for (int i = 0; i < bitStringCodeLength; i += 8) {
+	// the whole file is built in memory, so it goes to the disk in large writes
+	bufferType outputFile(sizeof(int) + 1 + (bitStringCodeLength + 7) / 8, 0);
 
-			bitset<8> byteArr = 0; // byte array
+	memcpy(outputFile.data(), &bitStringCodeLength, sizeof(int));
+	outputFile[sizeof(int)] = endBitStringCode;
 
-			for (int k = i; k < i + 8; k++) {
+	unsigned char * byteArr = outputFile.data() + sizeof(int) + 1; // byte array
 
-				bool test = (*(letter + k) == '1' ? true : false);
+	// convert bits into an actual bit stream (the padding bits of the last byte are 0)
+	for (int k = 0; k < bitStringCodeLength; k++) {
 
-				byteArr |= (test ? 1 : 0) << 7 - (k - i);
+		if (*(letter + k) == '1') {
 
-			}
-
-			outputFile.write((const char *) &byteArr, 1);
+			byteArr[k / 8] |= 1 << (7 - k % 8);
 
 		}
 
-		outputFile.close();
-
 	}
 
+	return writeFile(outputFileName + ".bin", outputFile, options);
+
 }
 
 // extra credit (read in and unpack bitstream)
 // output file ()
 void DPLKYL002::HuffmanTree::decompress(string inputFileName,
-		string outputFileName) {
+		string outputFileName, const Options & options) {
 
-	unordered_map<string, string> map;
+	string decodedbitStringCode;
+
+	if (!decodeLegacyFiles(inputFileName, decodedbitStringCode, options)) {
+
+		return;
+
+	}
+
+	// write out letters to output file
+	writeFile(outputFileName,
+			bufferType(decodedbitStringCode.begin(), decodedbitStringCode.end()),
+			options);
+
+}
+
+// the code table file (bit string code -> letter)
+bool DPLKYL002::HuffmanTree::readCodeTableFile(string inputFileName,
+		unordered_map<string, string> & map) {
 
 	ifstream inputFile((inputFileName + ".hdr").c_str()); // code table file
 
 	if (!inputFile) {
 
 		cout << "Unable to open: " << inputFileName + ".hdr" << endl;
-		return;
+		return false;
 
 	}
 
@@ -339,20 +404,34 @@ void DPLKYL002::HuffmanTree::decompress(string inputFileName,
 
 	inputFile.close();
 
+	return true;
+
+}
+
+// reads the code table (.hdr) and binary (.bin) files and decodes them to letters
+bool DPLKYL002::HuffmanTree::decodeLegacyFiles(string inputFileName,
+		string & decodedbitStringCode, const Options & options) {
+
+	unordered_map<string, string> map;
+
+	if (!readCodeTableFile(inputFileName, map)) {
+
+		return false;
+
+	}
+
 	// convert input binary file to bit stream
-	inputFile.open((inputFileName + ".bin").c_str(), ios::binary); // binary file
+	bufferType binaryFile;
 
-	if (!inputFile) {
+	if (!readFile(inputFileName + ".bin", binaryFile, options)) {
 
-		cout << "Unable to open: " << inputFileName + ".bin" << endl;
-		return;
+		return false;
 
 	}
 
-	int numBits, numBytes;
-	char letter;
+	int numBits = 0, numBytes;
 
-	inputFile.read(reinterpret_cast<char *>(&numBits), sizeof(int));
+	memcpy(&numBits, binaryFile.data(), min(binaryFile.size(), sizeof(int)));
 
 	/*To compute the actual packed file size in bytes (approximately) you can compute:
 	 (Nbits/8) + (Nbits%8 ? 1 : 0) using integer arithmetic. This accommodates
@@ -360,69 +439,975 @@ void DPLKYL002::HuffmanTree::decompress(string inputFileName,
 	 of 2.
 	 */
 
+	numBits = max(0, numBits);
 	numBytes = (numBits / 8) + (numBits % 8 ? 1 : 0);
 
-	inputFile.read(&letter, 1);
+	// skip the '\n' after the header
+	size_t start = min(binaryFile.size(), sizeof(int) + 1);
+
+	bufferType byteArr(numBytes, 0); // byte array
+
+	copy(binaryFile.begin() + start,
+			binaryFile.begin() + min(binaryFile.size(), start + numBytes),
+			byteArr.begin());
+
+	/*decode the bit stream straight from the bytes (most significant bit first), on
+	  several threads for large files; it stops at numBits so the padding bits of the
+	  last byte are not decoded
+	  */
+	vector<int> links;
+
+	decodedbitStringCode.clear();
+	buildLegacyCode(map, links);
+	decodeLegacyStream(links, byteArr.data(), numBits, decodedbitStringCode,
+			options.threads);
+
+	return true;
+
+}
+
+// canonical codes - only the code length of each symbol needs to be stored in a header
+void DPLKYL002::HuffmanTree::buildCodeLengths(
+		const vector<unsigned int> & frequencies,
+		vector<unsigned char> & codeLengths, unsigned int maxLength) {
+
+	vector<unsigned int> scaledFrequencies(frequencies);
 
-	bitset<8> * byteArr = new bitset<8> [numBytes];
+	while (true) {
 
-	for (int i = 0; i < numBytes; i++) {
+		priority_queue<nodeType, vector<nodeType>, HuffmanTree::Compare> priorityQueue;
 
-		inputFile.read((char *) &byteArr[i], 1);
+		for (unsigned int s = 0; s < scaledFrequencies.size(); s++) {
+
+			if (scaledFrequencies[s] > 0) {
+
+				priorityQueue.push(
+						HuffmanTree::HuffmanNode('\0', s, scaledFrequencies[s]));
+
+			}
+
+		}
+
+		codeLengths.assign(frequencies.size(), 0);
+
+		if (priorityQueue.empty()) {
+
+			return;
+
+		}
+
+		// a single symbol still needs a one bit code
+		if (priorityQueue.size() == 1) {
+
+			codeLengths[priorityQueue.top().getSymbol()] = 1;
+			return;
+
+		}
+
+		HuffmanTree::HuffmanNode node(buildHuffmanTree(priorityQueue));
+		assignCodeLengths(node, codeLengths, 0);
+
+		if (*max_element(codeLengths.begin(), codeLengths.end()) <= maxLength) {
+
+			return;
+
+		}
+
+		/*The tree is too deep for the decoder: flatten the frequency distribution
+		  (keeping every symbol present) and build the tree again.
+		  */
+		for (auto & frequency : scaledFrequencies) {
+
+			if (frequency > 0) {
+
+				frequency = (frequency >> 1) | 1;
+
+			}
+
+		}
 
 	}
 
-	inputFile.close();
+}
+
+void DPLKYL002::HuffmanTree::assignCodeLengths(const nodeType & node,
+		vector<unsigned char> & codeLengths, unsigned int depth) {
+
+	// leaf node - the code length is the depth of the leaf
+	if (node.leftLink == nullptr) {
+
+		codeLengths[node.getSymbol()] = depth;
+		return;
+
+	}
+
+	assignCodeLengths(*(node.leftLink), codeLengths, depth + 1);
+	assignCodeLengths(*(node.rightLink), codeLengths, depth + 1);
+
+}
+
+void DPLKYL002::HuffmanTree::buildCanonicalCodes(
+		const vector<unsigned char> & codeLengths, vector<unsigned int> & codes) {
+
+	/*Codes of the same length are consecutive integers assigned in symbol order, and
+	  shorter codes come before longer ones (as in DEFLATE). The codes are stored bit
+	  reversed, ready to be written least significant bit first by BitWriter.
+	  */
+	unsigned int lengthCount[maxCodeLength + 1] = { 0 };
+	unsigned int nextCode[maxCodeLength + 1] = { 0 };
+
+	for (unsigned char length : codeLengths) {
+
+		lengthCount[length]++;
+
+	}
+
+	lengthCount[0] = 0;
+
+	unsigned int code = 0;
+
+	for (unsigned int length = 1; length <= maxCodeLength; length++) {
+
+		code = (code + lengthCount[length - 1]) << 1;
+		nextCode[length] = code;
+
+	}
+
+	codes.assign(codeLengths.size(), 0);
+
+	for (unsigned int s = 0; s < codeLengths.size(); s++) {
+
+		unsigned int length = codeLengths[s];
+
+		if (length == 0) {
+
+			continue;
+
+		}
+
+		unsigned int canonicalCode = nextCode[length]++;
+		unsigned int reversedCode = 0;
+
+		for (unsigned int i = 0; i < length; i++) {
+
+			reversedCode = (reversedCode << 1) | ((canonicalCode >> i) & 1);
+
+		}
+
+		codes[s] = reversedCode;
+
+	}
+
+}
+
+// code length header: number of symbols, then 4 bits per symbol
+void DPLKYL002::HuffmanTree::writeCodeLengths(BitWriter & writer,
+		const vector<unsigned char> & codeLengths) {
+
+	unsigned int numSymbols = codeLengths.size();
+
+	// trailing unused symbols are not stored
+	while (numSymbols > 0 && codeLengths[numSymbols - 1] == 0) {
+
+		numSymbols--;
+
+	}
+
+	writer.writeBits(numSymbols, 24);
+
+	for (unsigned int s = 0; s < numSymbols; s++) {
+
+		writer.writeBits(codeLengths[s], 4);
+
+	}
+
+}
+
+bool DPLKYL002::HuffmanTree::readCodeLengths(BitReader & reader,
+		vector<unsigned char> & codeLengths) {
+
+	unsigned int numSymbols = reader.readBits(24);
+
+	codeLengths.assign(numSymbols, 0);
+
+	for (unsigned int s = 0; s < numSymbols && !reader.overrun(); s++) {
+
+		codeLengths[s] = reader.readBits(4);
+
+	}
+
+	return !reader.overrun();
+
+}
+
+DPLKYL002::HuffmanTree::DecodeTable::DecodeTable() :
+		tableBits(1), singleLookup(true), entries(2, 0) {
+
+	fill(counts, counts + maxCodeLength + 1, 0);
+
+}
 
-	// convert bit stream to bit string code
-	string bitStringCode, individualBit;
+bool DPLKYL002::HuffmanTree::DecodeTable::build(
+		const vector<unsigned char> & codeLengths) {
 
-	for (int j = 0; j < numBytes; j++) {
+	fill(counts, counts + maxCodeLength + 1, 0);
 
-		for (int i = 7; i > -1; i--) {
+	unsigned int maxLength = 1;
 
-			bitset<8> tempArr;
+	for (unsigned char length : codeLengths) {
 
-			tempArr = byteArr[j] & (bitset<8> ) 1 << i; // extract individual bit at position j in byte array
-			tempArr = tempArr >> i;
+		if (length > maxCodeLength) {
 
-			individualBit = (tempArr == 1 ? '1' : '0');
-			bitStringCode += individualBit;
+			return false;
 
 		}
 
+		counts[length]++;
+		maxLength = max(maxLength, (unsigned int) length);
+
 	}
 
-	delete[] byteArr;
+	counts[0] = 0;
 
-	// decode bit string code
-	string decodedbitStringCode, line;
+	// reject over-subscribed codes (incomplete codes, e.g. a single symbol, are allowed)
+	int left = 1;
 
-	for (int k = 0; k < bitStringCode.size(); k++) {
+	for (unsigned int length = 1; length <= maxCodeLength; length++) {
 
-		string letter = bitStringCode.substr(k, 1);
-		line += letter;
+		left = (left << 1) - counts[length];
 
-		if (map.find(line) != map.end()) {
+		if (left < 0) {
 
-			decodedbitStringCode += map[line];
-			line = "";
+			return false;
 
 		}
-		if (k == numBits) {
 
-			break;
+	}
+
+	// symbols in canonical order
+	unsigned int offsets[maxCodeLength + 2] = { 0 };
+
+	for (unsigned int length = 1; length <= maxCodeLength; length++) {
+
+		offsets[length + 1] = offsets[length] + counts[length];
+
+	}
+
+	sortedSymbols.assign(offsets[maxCodeLength + 1], 0);
+
+	for (unsigned int s = 0; s < codeLengths.size(); s++) {
+
+		if (codeLengths[s] != 0) {
+
+			sortedSymbols[offsets[codeLengths[s]]++] = s;
 
 		}
+
 	}
 
-	// write out letters to output file
-	ofstream outputFile(outputFileName.c_str());
+	// lookup table indexed by the next tableBits bits of the stream
+	tableBits = min(maxLength, lookupBits);
+	singleLookup = maxLength <= lookupBits;
+	entries.assign(1u << tableBits, 0);
 
-	while (outputFile.is_open()) {
+	HuffmanTree tree;
+	vector<unsigned int> codes;
+	tree.buildCanonicalCodes(codeLengths, codes);
 
-		outputFile << decodedbitStringCode;
-		outputFile.close();
+	for (unsigned int s = 0; s < codeLengths.size(); s++) {
+
+		unsigned int length = codeLengths[s];
+
+		if (length == 0 || length > tableBits) {
+
+			continue;
+
+		}
+
+		// every table index starting with this (reversed) code decodes to the symbol
+		for (unsigned int i = codes[s]; i < entries.size(); i += 1u << length) {
+
+			entries[i] = (s << 5) | length;
+
+		}
+
+	}
+
+	return true;
+
+}
+
+unsigned int DPLKYL002::HuffmanTree::DecodeTable::decodeSlow(
+		BitReader & reader) const {
+
+	// walk the canonical code one bit at a time
+	int code = 0, first = 0, index = 0;
+
+	for (unsigned int length = 1; length <= maxCodeLength; length++) {
+
+		code |= reader.readBits(1);
+
+		int count = counts[length];
+
+		if (code - first < count) {
+
+			return sortedSymbols[index + (code - first)];
+
+		}
+
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+
+	}
+
+	return invalidSymbol;
+
+}
+
+DPLKYL002::HuffmanTree::DecodeTableCache::DecodeTableCache(
+		unsigned int capacity) :
+		capacity(capacity), hits(0), misses(0) {
+
+}
+
+shared_ptr<const DPLKYL002::HuffmanTree::DecodeTable> DPLKYL002::HuffmanTree::DecodeTableCache::find(
+		const vector<unsigned char> & codeLengths) {
+
+	HuffmanTree tree;
+	unsigned int key = tree.tableIdentifier(codeLengths);
+
+	{
+		lock_guard<mutex> guard(lock);
+
+		auto found = index.find(key);
+
+		if (found != index.end() && found->second->codeLengths == codeLengths) {
+
+			// move to the front of the use order
+			entries.splice(entries.begin(), entries, found->second);
+			hits++;
+
+			return found->second->table;
+
+		}
+
+		misses++;
+
+	}
+
+	// build outside the lock, so other decoders are not held up
+	shared_ptr<DecodeTable> table = make_shared<DecodeTable>();
+
+	if (!table->build(codeLengths)) {
+
+		return nullptr;
+
+	}
+
+	lock_guard<mutex> guard(lock);
+
+	if (capacity == 0) {
+
+		return table;
+
+	}
+
+	auto found = index.find(key);
+
+	if (found != index.end()) {
+
+		// another decoder got there first, or a hash collision - keep the newest
+		entries.erase(found->second);
+		index.erase(found);
+
+	}
+
+	while (entries.size() >= capacity) {
+
+		index.erase(tree.tableIdentifier(entries.back().codeLengths));
+		entries.pop_back();
+
+	}
+
+	entries.push_front(Entry { codeLengths, table });
+	index[key] = entries.begin();
+
+	return table;
+
+}
+
+void DPLKYL002::HuffmanTree::DecodeTableCache::setCapacity(
+		unsigned int capacity) {
+
+	lock_guard<mutex> guard(lock);
+
+	this->capacity = capacity;
+
+	HuffmanTree tree;
+
+	while (entries.size() > capacity) {
+
+		index.erase(tree.tableIdentifier(entries.back().codeLengths));
+		entries.pop_back();
+
+	}
+
+}
+
+unsigned long long DPLKYL002::HuffmanTree::DecodeTableCache::getHits(void) {
+
+	lock_guard<mutex> guard(lock);
+
+	return hits;
+
+}
+
+unsigned long long DPLKYL002::HuffmanTree::DecodeTableCache::getMisses(void) {
+
+	lock_guard<mutex> guard(lock);
+
+	return misses;
+
+}
+
+shared_ptr<const DPLKYL002::HuffmanTree::DecodeTable> DPLKYL002::HuffmanTree::findDecodeTable(
+		const vector<unsigned char> & codeLengths) {
+
+	return decodeTableCache.find(codeLengths);
+
+}
+
+// the backend used for options (iostreams can not bypass the page cache)
+DPLKYL002::FileIO::Backend DPLKYL002::HuffmanTree::fileBackend(
+		const Options & options) {
+
+	if (options.directIO && options.backend == FileIO::BACKEND_STREAMS) {
+
+		return FileIO::BACKEND_PREAD;
+
+	}
+
+	return options.backend;
+
+}
+
+bool DPLKYL002::HuffmanTree::readFile(string fileName, bufferType & buffer,
+		const Options & options) {
+
+	FileIO::Backend backend = fileBackend(options);
+
+	if (backend != FileIO::BACKEND_STREAMS) {
+
+		int fd = FileIO::openFile(fileName, false, options.directIO);
+		unsigned long long size;
+
+		if (fd < 0 || !FileIO::fileSize(fd, size)) {
+
+			FileIO::closeFile(fd);
+			cout << "Unable to open: " << fileName << endl;
+			return false;
+
+		}
+
+		buffer.resize(size);
+
+		long long numRead;
+
+		if (options.directIO) {
+
+			// O_DIRECT needs aligned memory, which buffer may not be
+			FileIO::DirectReader reader(fd, backend,
+					min(size, (unsigned long long) FileIO::directBufferSize),
+					options.hugePages);
+
+			numRead = reader.read(buffer.data(), size);
+
+		} else {
+
+			numRead = FileIO::readAt(fd, buffer.data(), size, 0, backend);
+
+		}
+
+		FileIO::closeFile(fd);
+
+		if (numRead < 0) {
+
+			cout << "Unable to read: " << fileName << endl;
+			return false;
+
+		}
+
+		buffer.resize(numRead); // the file may have shrunk since fileSize
+
+		return true;
+
+	}
+
+	ifstream inputFile(fileName.c_str(), ios::binary);
+
+	if (!inputFile) {
+
+		cout << "Unable to open: " << fileName << endl;
+		return false;
+
+	}
+
+	inputFile.seekg(0, ios::end);
+	buffer.resize((size_t) inputFile.tellg());
+	inputFile.seekg(0, ios::beg);
+
+	inputFile.read((char *) buffer.data(), buffer.size());
+	inputFile.close();
+
+	return true;
+
+}
+
+bool DPLKYL002::HuffmanTree::writeFile(string fileName,
+		const bufferType & buffer, const Options & options) {
+
+	FileIO::Backend backend = fileBackend(options);
+
+	if (backend != FileIO::BACKEND_STREAMS) {
+
+		int fd = FileIO::openFile(fileName, true, options.directIO);
+
+		if (fd < 0) {
+
+			cout << "Unable to open: " << fileName << endl;
+			return false;
+
+		}
+
+		bool written;
+
+		if (options.directIO) {
+
+			FileIO::DirectWriter writer(fd, backend,
+					min(buffer.size(), (size_t) FileIO::directBufferSize),
+					options.hugePages);
+
+			written = writer.write(buffer.data(), buffer.size()) && writer.finish();
+
+		} else {
+
+			written = FileIO::writeAt(fd, buffer.data(), buffer.size(), 0, backend)
+					== (long long) buffer.size();
+
+		}
+
+		FileIO::closeFile(fd);
+
+		if (!written) {
+
+			cout << "Unable to write: " << fileName << endl;
+			return false;
+
+		}
+
+		return true;
+
+	}
+
+	ofstream outputFile(fileName.c_str(), ios::binary);
+
+	if (!outputFile.is_open()) {
+
+		cout << "Unable to open: " << fileName << endl;
+		return false;
+
+	}
+
+	outputFile.write((const char *) buffer.data(), buffer.size());
+	outputFile.close();
+
+	return true;
+
+}
+
+// integers are stored little endian
+void DPLKYL002::HuffmanTree::appendInteger(bufferType & buffer,
+		unsigned long long value, unsigned int numBytes) {
+
+	for (unsigned int i = 0; i < numBytes; i++) {
+
+		buffer.push_back((unsigned char) (value >> (8 * i)));
+
+	}
+
+}
+
+bool DPLKYL002::HuffmanTree::readInteger(const bufferType & buffer,
+		size_t & position, unsigned int numBytes, unsigned long long & value) {
+
+	if (position + numBytes > buffer.size()) {
+
+		return false;
+
+	}
+
+	value = 0;
+
+	for (unsigned int i = 0; i < numBytes; i++) {
+
+		value |= (unsigned long long) buffer[position++] << (8 * i);
+
+	}
+
+	return true;
+
+}
+
+// variable length integers: 7 bits per byte, least significant first, high bit set if more follow
+void DPLKYL002::HuffmanTree::appendVarint(bufferType & buffer,
+		unsigned long long value) {
+
+	while (value >= 0x80) {
+
+		buffer.push_back((unsigned char) (value | 0x80));
+		value >>= 7;
+
+	}
+
+	buffer.push_back((unsigned char) value);
+
+}
+
+bool DPLKYL002::HuffmanTree::readVarint(const unsigned char * data,
+		size_t size, size_t & position, unsigned long long & value) {
+
+	value = 0;
+
+	for (unsigned int shift = 0; shift < 64 && position < size; shift += 7) {
+
+		unsigned char byte = data[position++];
+		value |= (unsigned long long) (byte & 0x7F) << shift;
+
+		if (!(byte & 0x80)) {
+
+			return true;
+
+		}
+
+	}
+
+	return false;
+
+}
+
+/*Binary container header: the magic bytes "DPLH", a version, the front-end transform and
+  two bytes reserved for flags.
+  */
+void DPLKYL002::HuffmanTree::appendContainerHeader(bufferType & buffer,
+		FrontEnd frontEnd) {
+
+	const char magic[] = "DPLH";
+
+	buffer.insert(buffer.end(), magic, magic + 4);
+	buffer.push_back(1); // version
+	buffer.push_back((unsigned char) frontEnd);
+	buffer.push_back(0);
+	buffer.push_back(0);
+
+}
+
+bool DPLKYL002::HuffmanTree::readContainerHeader(const bufferType & buffer,
+		size_t & position, FrontEnd & frontEnd) {
+
+	if (position + 8 > buffer.size()
+			|| string(buffer.begin() + position, buffer.begin() + position + 4)
+					!= "DPLH" || buffer[position + 4] != 1) {
+
+		return false;
+
+	}
+
+	frontEnd = (FrontEnd) buffer[position + 5];
+	position += 8;
+
+	return true;
+
+}
+
+// word-level alphabet mode
+void DPLKYL002::HuffmanTree::compressWords(string inputFileName,
+		string outputFileName) {
+
+	bufferType input, output;
+
+	if (!readFile(inputFileName, input)) {
+
+		return;
+
+	}
+
+	appendContainerHeader(output, FRONT_END_WORDS);
+	encodeWords(input, output);
+
+	writeFile(outputFileName, output);
+
+}
+
+void DPLKYL002::HuffmanTree::decompressWords(string inputFileName,
+		string outputFileName) {
+
+	bufferType input, output;
+
+	if (!readFile(inputFileName, input)) {
+
+		return;
+
+	}
+
+	size_t position = 0;
+	FrontEnd frontEnd;
+
+	if (!readContainerHeader(input, position, frontEnd)
+			|| frontEnd != FRONT_END_WORDS) {
+
+		cout << "Not a word mode file: " << inputFileName << endl;
+		return;
+
+	}
+
+	if (!decodeWords(input, position, output)) {
+
+		cout << "Corrupt compressed file: " << inputFileName << endl;
+		return;
+
+	}
+
+	writeFile(outputFileName, output);
+
+}
+
+void DPLKYL002::HuffmanTree::encodeWords(const bufferType & input,
+		bufferType & output) {
+
+	/*The alphabet is every byte value followed by a dictionary of frequent words and
+	  separators. Frequent tokens are coded as a single symbol; rare tokens fall back to
+	  being spelt out one byte symbol at a time.
+	  */
+	vector<string> dictionary;
+	vector<unsigned int> symbols;
+
+	createWordDictionary(input, dictionary);
+	tokenizeWords(input, dictionary, symbols);
+
+	vector<unsigned int> frequencies(256 + dictionary.size(), 0);
+
+	for (unsigned int symbol : symbols) {
+
+		frequencies[symbol]++;
+
+	}
+
+	vector<unsigned char> codeLengths;
+	vector<unsigned int> codes;
+
+	buildCodeLengths(frequencies, codeLengths);
+	buildCanonicalCodes(codeLengths, codes);
+
+	/*Header: original size, then the dictionary (entry count followed by a length byte
+	  and the characters of each entry), then the code lengths.
+	  */
+	appendInteger(output, input.size(), 8);
+	appendInteger(output, dictionary.size(), 4);
+
+	for (const auto & token : dictionary) {
+
+		output.push_back((unsigned char) token.size());
+		output.insert(output.end(), token.begin(), token.end());
+
+	}
+
+	BitWriter writer(output);
+	writeCodeLengths(writer, codeLengths);
+
+	for (unsigned int symbol : symbols) {
+
+		writer.writeBits(codes[symbol], codeLengths[symbol]);
+
+	}
+
+	writer.flush();
+
+}
+
+bool DPLKYL002::HuffmanTree::decodeWords(const bufferType & input,
+		size_t position, bufferType & output) {
+
+	unsigned long long originalSize, dictionarySize;
+
+	if (!readInteger(input, position, 8, originalSize)
+			|| !readInteger(input, position, 4, dictionarySize)) {
+
+		return false;
+
+	}
+
+	vector<string> dictionary;
+
+	for (unsigned long long i = 0; i < dictionarySize; i++) {
+
+		if (position >= input.size()
+				|| position + 1 + input[position] > input.size()) {
+
+			return false;
+
+		}
+
+		unsigned int length = input[position++];
+		dictionary.push_back(
+				string(input.begin() + position,
+						input.begin() + position + length));
+		position += length;
+
+	}
+
+	BitReader reader(input.data() + position, input.size() - position);
+	vector<unsigned char> codeLengths;
+	shared_ptr<const DecodeTable> table;
+
+	if (!readCodeLengths(reader, codeLengths)
+			|| !(table = findDecodeTable(codeLengths))) {
+
+		return false;
+
+	}
+
+	size_t outputStart = output.size();
+
+	while (output.size() - outputStart < originalSize) {
+
+		unsigned int symbol = table->decode(reader);
+
+		if (reader.overrun() || symbol >= 256 + dictionary.size()) {
+
+			return false;
+
+		}
+
+		if (symbol < 256) {
+
+			output.push_back((unsigned char) symbol);
+
+		} else {
+
+			const string & token = dictionary[symbol - 256];
+			output.insert(output.end(), token.begin(), token.end());
+
+		}
+
+	}
+
+	return output.size() - outputStart == originalSize;
+
+}
+
+// a token is a run of letters (a word) or a run of other characters (a separator)
+static size_t nextTokenEnd(const DPLKYL002::HuffmanTree::bufferType & input,
+		size_t start) {
+
+	bool isWord = isalpha(input[start]);
+	size_t end = start + 1;
+
+	while (end < input.size() && (bool) isalpha(input[end]) == isWord
+			&& end - start < 255) {
+
+		end++;
+
+	}
+
+	return end;
+
+}
+
+void DPLKYL002::HuffmanTree::createWordDictionary(const bufferType & input,
+		vector<string> & dictionary) {
+
+	const unsigned int maxDictionarySize = 16128; // keeps the alphabet under 2^14 symbols
+
+	unordered_map<string, unsigned int> tokenCounts;
+
+	for (size_t start = 0; start < input.size();) {
+
+		size_t end = nextTokenEnd(input, start);
+		tokenCounts[string(input.begin() + start, input.begin() + end)]++;
+		start = end;
+
+	}
+
+	/*Tokens seen only once, and single characters, are cheaper to spell out than to
+	  store in the dictionary. The rest are ranked by the number of symbols they save.
+	  */
+	vector<pair<unsigned long long, string>> candidates;
+
+	for (const auto & token : tokenCounts) {
+
+		if (token.second >= 2 && token.first.size() >= 2) {
+
+			candidates.push_back(
+					{ (unsigned long long) token.second * (token.first.size() - 1),
+							token.first });
+
+		}
+
+	}
+
+	sort(candidates.begin(), candidates.end(),
+			[](const pair<unsigned long long, string> & a,
+					const pair<unsigned long long, string> & b) {
+
+				return a.first != b.first ? a.first > b.first : a.second < b.second;
+
+			});
+
+	dictionary.clear();
+
+	for (size_t i = 0; i < candidates.size() && i < maxDictionarySize; i++) {
+
+		dictionary.push_back(candidates[i].second);
+
+	}
+
+}
+
+void DPLKYL002::HuffmanTree::tokenizeWords(const bufferType & input,
+		const vector<string> & dictionary, vector<unsigned int> & symbols) {
+
+	unordered_map<string, unsigned int> dictionaryIndex;
+
+	for (unsigned int i = 0; i < dictionary.size(); i++) {
+
+		dictionaryIndex.insert( { dictionary[i], 256 + i });
+
+	}
+
+	symbols.clear();
+
+	for (size_t start = 0; start < input.size();) {
+
+		size_t end = nextTokenEnd(input, start);
+		auto found = dictionaryIndex.find(
+				string(input.begin() + start, input.begin() + end));
+
+		if (found != dictionaryIndex.end()) {
+
+			symbols.push_back(found->second);
+
+		} else {
+
+			for (size_t i = start; i < end; i++) {
+
+				symbols.push_back(input[i]);
+
+			}
+
+		}
+
+		start = end;
 
 	}
 
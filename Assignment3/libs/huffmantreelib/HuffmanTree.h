@@ -9,7 +9,17 @@
 
 #include <queue>
 #include <memory>
+#include <string>
+#include <vector>
 #include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <list>
+
+#include "BitStream.h"
+#include "FileIO.h"
+#include "LZ77.h"
 
 #ifndef LIBS_HUFFMANTREE_H
 #define LIBS_HUFFMANNTREE_H
@@ -28,6 +38,7 @@ public:
 
 	private:
 		char letter;
+		unsigned int symbol; // index into the alphabet (the letter itself for byte alphabets)
 		unsigned int frequency;
 
 	public:
@@ -41,7 +52,16 @@ public:
 
 		// constructor defined to use the specified smart pointers to manage memory above
 		HuffmanNode(char c, unsigned int f) :
-				letter(c), frequency(f) {
+				letter(c), symbol((unsigned char) c), frequency(f) {
+
+			leftLink = nullptr;
+			rightLink = nullptr;
+
+		}
+
+		// constructor for alphabets larger than a byte (e.g. word tokens)
+		HuffmanNode(char c, unsigned int s, unsigned int f) :
+				letter(c), symbol(s), frequency(f) {
 
 			leftLink = nullptr;
 			rightLink = nullptr;
@@ -51,6 +71,7 @@ public:
 		HuffmanNode(const HuffmanNode & huffmanNode) {
 
 			this->letter = huffmanNode.letter;
+			this->symbol = huffmanNode.symbol;
 			this->frequency = huffmanNode.frequency;
 			this->leftLink = huffmanNode.leftLink;
 			this->rightLink = huffmanNode.rightLink;
@@ -63,6 +84,12 @@ public:
 
 		}
 
+		unsigned int getSymbol(void) const {
+
+			return this->symbol;
+
+		}
+
 		unsigned int getFrequency(void) const {
 
 			return this->frequency;
@@ -90,6 +117,107 @@ public:
 		}
 	};
 
+	// longest code length produced for the binary (non-legacy) formats
+	static const unsigned int maxCodeLength = 15;
+
+	/*Decodes canonical codes written by BitWriter. Codes up to tableBits long are decoded
+	  with a single table lookup, longer codes fall back to walking the canonical code
+	  one bit at a time.
+	  */
+	class DecodeTable {
+
+	private:
+		unsigned int tableBits;
+		bool singleLookup; // every code is at most tableBits long
+		vector<unsigned int> entries; // (symbol << 5) | code length, 0 for long / invalid codes
+		unsigned int counts[maxCodeLength + 1]; // number of codes of each length
+		vector<unsigned int> sortedSymbols; // symbols ordered by code length, then by symbol
+
+		unsigned int decodeSlow(BitReader & reader) const;
+
+	public:
+
+		static const unsigned int invalidSymbol = 0xFFFFFFFF;
+
+		// codes up to this long are decoded with one table lookup
+		static const unsigned int lookupBits = 11;
+
+		DecodeTable();
+
+		// returns false if the code lengths do not describe a prefix code
+		bool build(const vector<unsigned char> & codeLengths);
+
+		// raw table access for the lane-parallel decoder
+		unsigned int getTableBits(void) const {
+
+			return tableBits;
+
+		}
+
+		const unsigned int * getEntries(void) const {
+
+			return entries.data();
+
+		}
+
+		bool isSingleLookup(void) const {
+
+			return singleLookup;
+
+		}
+
+		unsigned int decode(BitReader & reader) const {
+
+			unsigned int entry = entries[reader.peekBits(tableBits)];
+
+			if (entry & 0x1F) {
+
+				reader.skipBits(entry & 0x1F);
+				return entry >> 5;
+
+			}
+
+			return decodeSlow(reader);
+
+		}
+	};
+
+	/*Built decode tables shared by every decoder in the process, keyed by a hash of the
+	  code lengths, so files and blocks with the same code build their table once. The
+	  least recently used table is dropped when the cache is full.
+	  */
+	class DecodeTableCache {
+
+	private:
+
+		class Entry {
+		public:
+
+			vector<unsigned char> codeLengths;
+			shared_ptr<const DecodeTable> table;
+
+		};
+
+		mutex lock;
+		list<Entry> entries; // most recently used first
+		unordered_map<unsigned int, list<Entry>::iterator> index;
+		unsigned int capacity;
+		unsigned long long hits, misses;
+
+	public:
+
+		DecodeTableCache(unsigned int capacity = 64);
+
+		// the table for these code lengths, nullptr if they are not a prefix code
+		shared_ptr<const DecodeTable> find(const vector<unsigned char> & codeLengths);
+		void setCapacity(unsigned int capacity);
+
+		unsigned long long getHits(void);
+		unsigned long long getMisses(void);
+	};
+
+	static DecodeTableCache decodeTableCache;
+
 
 		/*Prior to constructing the huffman encoding tree you have to count the number of
 		  occurrences of each letter in the file. To store these frequencies you can use a
@@ -106,24 +234,373 @@ public:
 		typedef unordered_map<char, string> & codeType;
 		typedef HuffmanTree::HuffmanNode nodeType;
 		typedef priority_queue<nodeType, vector<nodeType>, HuffmanTree::Compare> & queueType;
+		typedef vector<unsigned char> bufferType;
+
+		// front-end transforms applied before entropy coding, recorded in the container header
+		enum FrontEnd {
+			FRONT_END_BYTES = 0,
+			FRONT_END_WORDS = 1,
+			FRONT_END_RLE = 2,
+			FRONT_END_BWT = 3,
+			FRONT_END_LZ77 = 4,
+			FRONT_END_TRAINED = 5
+		};
+
+		// how the payload of a block is coded
+		enum BlockType {
+			BLOCK_HUFFMAN = 0, BLOCK_SINGLE = 1, BLOCK_STORED = 2, BLOCK_STATIC = 3
+		};
+
+		// settings for the binary container modes
+		class Options {
+		public:
+
+			FrontEnd frontEnd;
+			unsigned int blockSize; // bytes of input coded per block
+			unsigned int threads; // tasks a block, batch or stream is split into (run on ThreadPool::shared())
+			unsigned int level; // LZ77 match finder effort, 0 - 9
+			bool splitBlocks; // split blocks where the letter statistics change
+			unsigned int tableId; // trained table used by FRONT_END_TRAINED
+			string tableDirectory; // where trained tables are saved
+			FileIO::Backend backend; // how input and output files are read and written
+			bool directIO; // bypass the page cache (O_DIRECT, through aligned buffers)
+			bool hugePages; // back the aligned buffers with huge pages where possible
+			unsigned int syncInterval; // letters between the sync points of a legacy .idx file, 0 for none
+
+			Options() :
+					frontEnd(FRONT_END_BYTES), blockSize(1 << 20), threads(
+							max(1u, thread::hardware_concurrency())), level(6), splitBlocks(
+							false), tableId(0), tableDirectory("."), backend(
+							FileIO::BACKEND_STREAMS), directIO(false), hugePages(false), syncInterval(
+							0) {
+
+			}
+		};
+
+		// a code trained from a corpus, shared by every block of every file coded with it
+		class StaticTable {
+		public:
+
+			unsigned int id;
+			vector<unsigned char> codeLengths;
+			vector<unsigned int> codes;
+			vector<unsigned int> packedCodes; // for encodeSymbols
+			shared_ptr<const DecodeTable> decodeTable;
+
+		};
+
+		// run lengths are coded as symbols following the 256 byte values, one per power of two
+		static const unsigned int numRunClasses = 24;
 
 		// functions
-		void compress(string inputFileName, string outputFileName);
+		bool compress(string inputFileName, string outputFileName,
+				const Options & options = Options());
 
-		void createMap(HuffmanTree::mapType map, string inputFileName);
+		bool createMap(HuffmanTree::mapType map, string inputFileName,
+				const Options & options = Options());
 		void createPriorityQueue(HuffmanTree::queueType priorityQueue, HuffmanTree::mapType map);
 		HuffmanTree::HuffmanNode buildHuffmanTree(HuffmanTree::queueType priorityQueue);
 
 		void buildCodeTable(nodeType node, codeType map, string bitStringCode);
 		void createCodeTableFile(string outputFileName, codeType map);
 
-		string getBitStringCode(string inputFileName, codeType map);
-		void createCompressedInputFile(string outputFileName, string bitStringCode);
-		void createBinaryFile(string outputFileName, string bitStringCode);
-
-		void decompress(string inputBinaryFileName, string outputFileName);
-
-
+		string getBitStringCode(string inputFileName, codeType map,
+				const Options & options = Options(),
+				vector<unsigned long long> * syncPoints = nullptr);
+		bool createCompressedInputFile(string outputFileName, string bitStringCode,
+				const Options & options = Options());
+		bool createBinaryFile(string outputFileName, string bitStringCode,
+				const Options & options = Options());
+
+		void decompress(string inputBinaryFileName, string outputFileName,
+				const Options & options = Options());
+		bool readCodeTableFile(string inputFileName,
+				unordered_map<string, string> & map);
+		bool decodeLegacyFiles(string inputFileName, string & decodedbitStringCode,
+				const Options & options = Options());
+
+		// speculative parallel decoding of the legacy .bin stream (no index, first bit is the most significant)
+		static const unsigned int speculativeChunkBits = 1 << 20; // fewest bits per thread
+		static const unsigned int speculativeCodeStarts = 4096; // code starts a chunk records while looking for a sync point
+
+		void buildLegacyCode(const unordered_map<string, string> & map,
+				vector<int> & links);
+		void decodeLegacyStream(const vector<int> & links,
+				const unsigned char * data, unsigned long long numBits,
+				string & output, unsigned int numThreads);
+		size_t decodeLegacyLetters(const vector<int> & links,
+				const unsigned char * data, unsigned long long numBits,
+				unsigned long long & position, size_t count, string * output);
+
+		// sync points - the bit offset of every syncInterval'th letter, so a range of letters can be decoded alone
+		// (a block container range decodes only the blocks overlapping it)
+		static const string indexExtension; // added to the legacy output name (beside .hdr and .bin)
+
+		void createIndexFile(string outputFileName,
+				const vector<unsigned long long> & syncPoints,
+				unsigned long long numLetters, unsigned int syncInterval,
+				const Options & options = Options());
+		bool decompressRange(string inputFileName, unsigned long long offset,
+				unsigned long long length, bufferType & output,
+				const Options & options = Options());
+		bool decompressContainerRange(string inputFileName,
+				unsigned long long offset, unsigned long long length,
+				bufferType & output, const Options & options);
+
+		// canonical codes (shared by the binary container formats)
+		void buildCodeLengths(const vector<unsigned int> & frequencies,
+				vector<unsigned char> & codeLengths,
+				unsigned int maxLength = maxCodeLength);
+		void assignCodeLengths(const nodeType & node,
+				vector<unsigned char> & codeLengths, unsigned int depth);
+		void buildCanonicalCodes(const vector<unsigned char> & codeLengths,
+				vector<unsigned int> & codes);
+		void writeCodeLengths(BitWriter & writer,
+				const vector<unsigned char> & codeLengths);
+		bool readCodeLengths(BitReader & reader,
+				vector<unsigned char> & codeLengths);
+		shared_ptr<const DecodeTable> findDecodeTable(
+				const vector<unsigned char> & codeLengths);
+
+		// binary container helpers
+		bool readFile(string fileName, bufferType & buffer,
+				const Options & options = Options());
+		bool writeFile(string fileName, const bufferType & buffer,
+				const Options & options = Options());
+		FileIO::Backend fileBackend(const Options & options);
+		void appendInteger(bufferType & buffer, unsigned long long value,
+				unsigned int numBytes);
+		bool readInteger(const bufferType & buffer, size_t & position,
+				unsigned int numBytes, unsigned long long & value);
+		void appendVarint(bufferType & buffer, unsigned long long value);
+		bool readVarint(const unsigned char * data, size_t size,
+				size_t & position, unsigned long long & value);
+		void appendContainerHeader(bufferType & buffer, FrontEnd frontEnd);
+		bool readContainerHeader(const bufferType & buffer, size_t & position,
+				FrontEnd & frontEnd);
+
+		// block container modes (each block of the input is coded independently)
+		bool compressContainer(string inputFileName, string outputFileName,
+				const Options & options);
+		bool decompressContainer(string inputFileName, string outputFileName,
+				const Options & options = Options());
+		bool compressBuffer(const bufferType & input, bufferType & output,
+				const Options & options);
+
+		// read / encode / write pipeline for fixed size blocks (bounded queues, recycled buffers)
+		static const unsigned int pipelineBuffers = 2; // block buffers per encoder
+
+		bool compressStream(string inputFileName, string outputFileName,
+				const Options & options);
+		bool decompressBuffer(const bufferType & input, bufferType & output,
+				const Options & options = Options());
+
+		unsigned long long estimateCompressedSize(const bufferType & input,
+				const Options & options);
+		void chooseBlockSplits(const unsigned char * data, size_t size,
+				const Options & options, vector<size_t> & blockStarts);
+		unsigned long long estimateHuffmanBits(
+				const vector<unsigned int> & frequencies);
+		unsigned long long estimateHuffmanBits(
+				const vector<unsigned int> & frequencies,
+				vector<unsigned char> & codeLengths);
+		BlockType chooseBlockType(const vector<unsigned int> & frequencies,
+				size_t size, FrontEnd frontEnd,
+				vector<unsigned char> * codeLengths = nullptr);
+		void encodeBlock(const unsigned char * data, size_t size,
+				const Options & options, bufferType & output,
+				const StaticTable * staticTable = nullptr);
+		bool readBlockHeader(const bufferType & buffer, size_t & position,
+				size_t & rawSize, size_t & payloadSize, BlockType & blockType);
+		bool decodeBlock(const unsigned char * payload, size_t payloadSize,
+				BlockType blockType, FrontEnd frontEnd, size_t rawSize,
+				bufferType & output, const StaticTable * staticTable = nullptr);
+
+		void encodeBytes(const unsigned char * data, size_t size,
+				bufferType & payload, unsigned int threads = 1,
+				const vector<unsigned char> * blockCodeLengths = nullptr);
+		bool decodeBytes(const unsigned char * payload, size_t payloadSize,
+				size_t rawSize, bufferType & output);
+		void encodeRunLengths(const unsigned char * data, size_t size,
+				bufferType & payload);
+		bool decodeRunLengths(const unsigned char * payload, size_t payloadSize,
+				size_t rawSize, bufferType & output);
+		void encodeBlockSorted(const unsigned char * data, size_t size,
+				bufferType & payload);
+		bool decodeBlockSorted(const unsigned char * payload,
+				size_t payloadSize, size_t rawSize, bufferType & output);
+		void encodeLZ77(const unsigned char * data, size_t size,
+				unsigned int level, bufferType & payload);
+		bool decodeLZ77(const unsigned char * payload, size_t payloadSize,
+				size_t rawSize, bufferType & output);
+		void countLZ77Symbols(const vector<LZ77::Token> & tokens,
+				vector<unsigned int> & lengthFrequencies,
+				vector<unsigned int> & distanceFrequencies);
+		void writeLZ77Tokens(BitWriter & writer,
+				const vector<LZ77::Token> & tokens,
+				const vector<unsigned char> & lengthCodeLengths,
+				const vector<unsigned int> & lengthCodes,
+				const vector<unsigned char> & distanceCodeLengths,
+				const vector<unsigned int> & distanceCodes);
+
+		// trained tables (built once from a corpus, then used with no per-file header or first pass)
+		unsigned int trainTable(const vector<string> & corpusFileNames,
+				string tableDirectory);
+		unsigned int tableIdentifier(const vector<unsigned char> & codeLengths);
+		string tableFileName(string tableDirectory, unsigned int tableId);
+		bool loadTable(string tableDirectory, unsigned int tableId,
+				StaticTable & staticTable);
+		void encodeStatic(const unsigned char * data, size_t size,
+				const StaticTable & staticTable, bufferType & payload,
+				unsigned int threads = 1);
+		bool decodeStatic(const unsigned char * payload, size_t payloadSize,
+				size_t rawSize, const StaticTable & staticTable,
+				bufferType & output);
+
+		// built-in English model (zero header: the letter count, then the codes)
+		void encodeEnglish(const unsigned char * data, size_t size,
+				bufferType & output);
+		bool decodeEnglish(const unsigned char * data, size_t size,
+				bufferType & output);
+
+		// a view of one record of a batch
+		class Span {
+		public:
+
+			const unsigned char * data;
+			size_t size;
+
+			Span() :
+					data(nullptr), size(0) {
+
+			}
+
+			Span(const unsigned char * d, size_t s) :
+					data(d), size(s) {
+
+			}
+		};
+
+		// batches of at least this many bytes are split over options.threads
+		static const unsigned int batchThreshold = 1 << 18;
+
+		// batches of short records sharing one code (written once, to the batch header)
+		void compressBatch(const vector<Span> & inputs, bufferType & header,
+				vector<bufferType> & outputs, const Options & options);
+		bool decompressBatch(const bufferType & header,
+				const vector<Span> & inputs, vector<bufferType> & outputs,
+				const Options & options);
+		bool decodeRecord(const DecodeTable & table, const unsigned char * data,
+				size_t size, bufferType & output);
+
+		// encoder / decoder kernels for byte alphabets, picked for the processor at run time
+		static const unsigned int kernelThreshold = 64; // letters before the kernels are used
+		static const unsigned int pairTableThreshold = 1 << 18; // letters before the pair table pays off
+
+		static bool bmi2Supported(void);
+		void packCodes(const vector<unsigned int> & codes,
+				const vector<unsigned char> & codeLengths,
+				vector<unsigned int> & packedCodes);
+		void encodeSymbols(const unsigned char * data, size_t size,
+				const unsigned int * packedCodes, BitWriter & writer);
+		void decodeSymbols(const DecodeTable & table, BitReader & reader,
+				unsigned char * output, size_t count);
+
+		// intra-block parallel encoding (one bitstream, the same bits as encodeSymbols)
+		static const unsigned int encodeChunkSize = 1 << 16; // fewest letters per thread
+
+		void encodeSymbolsParallel(const unsigned char * data, size_t size,
+				const unsigned int * packedCodes, BitWriter & writer,
+				unsigned int numThreads);
+
+		// lane-parallel record decoding (AVX2 when the processor has it)
+		static const unsigned int numLanes = 8;
+
+		static bool simdSupported(void);
+		bool decodeRecords(const DecodeTable & table, const vector<Span> & inputs,
+				vector<bufferType> & outputs, size_t first, size_t last);
+		bool decodeRecordLanes(const DecodeTable & table, const Span * records,
+				bufferType * const * outputs, unsigned int numRecords);
+
+		// many files compressed side by side (one file at a time per task of the thread pool)
+		class FilesReport {
+		public:
+
+			size_t numFiles, numFailed;
+			unsigned long long inputBytes, outputBytes;
+			double seconds;
+
+			FilesReport() :
+					numFiles(0), numFailed(0), inputBytes(0), outputBytes(0), seconds(
+							0) {
+
+			}
+		};
+
+		static const string containerExtension; // added to the names of compressed files
+
+		bool listInputFiles(string path, vector<pair<string, string>> & files);
+		bool makeDirectories(string path);
+		FilesReport compressFiles(const vector<string> & paths,
+				string outputDirectory, const Options & options, unsigned int jobs);
+
+		// compressed files of any format, told apart by their first bytes (legacy ones by their .hdr / .bin files)
+		enum FileFormat {
+			FORMAT_UNKNOWN = 0, FORMAT_LEGACY = 1, FORMAT_CONTAINER = 2, FORMAT_GZIP = 3
+		};
+
+		FileFormat detectFormat(string fileName);
+		bool decompressFile(string inputFileName, bufferType & output,
+				const Options & options = Options());
+
+		// archives: many compressed members, then a central directory to find any one of them
+		class ArchiveMember {
+		public:
+
+			string name; // path relative to the archived directory
+			unsigned long long offset, compressedSize, originalSize;
+			unsigned int tableId; // trained table the member was coded with, 0 for none
+			unsigned int crc; // of the original bytes
+
+		};
+
+		bool createArchive(const vector<string> & paths, string archiveFileName,
+				const Options & options, unsigned int jobs = 1);
+		bool readArchiveDirectory(string archiveFileName,
+				vector<ArchiveMember> & members);
+		bool extractMember(string archiveFileName, string memberName,
+				bufferType & output, const Options & options = Options());
+		bool extractArchive(string archiveFileName, string outputDirectory,
+				const vector<string> & memberNames,
+				const Options & options = Options());
+		bool decodeMember(int fd, const ArchiveMember & member, bufferType & output,
+				const Options & options);
+
+		// gzip / DEFLATE output (dynamic Huffman blocks, optionally after the LZ77 front end)
+		bool compressGzip(string inputFileName, string outputFileName,
+				const Options & options);
+		bool decompressGzip(string inputFileName, string outputFileName,
+				const Options & options = Options());
+		void encodeGzip(const bufferType & input, bufferType & output,
+				const Options & options);
+		bool decodeGzip(const bufferType & input, bufferType & output);
+		void encodeDeflateBlock(BitWriter & writer,
+				const vector<LZ77::Token> & tokens, bool lastBlock);
+		bool decodeDeflateBlock(BitReader & reader, unsigned int blockType,
+				bufferType & output);
+		unsigned int crc32(const unsigned char * data, size_t size,
+				unsigned int crc = 0);
+
+		// word-level alphabet mode (alphabet of bytes plus a dictionary of frequent tokens)
+		void compressWords(string inputFileName, string outputFileName);
+		void decompressWords(string inputFileName, string outputFileName);
+		void encodeWords(const bufferType & input, bufferType & output);
+		bool decodeWords(const bufferType & input, size_t position,
+				bufferType & output);
+		void createWordDictionary(const bufferType & input,
+				vector<string> & dictionary);
+		void tokenizeWords(const bufferType & input,
+				const vector<string> & dictionary, vector<unsigned int> & symbols);
 
 };
 
@@ -0,0 +1,255 @@
+//=======================================================================================
+// Name        : LZ77.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "LZ77.h"
+
+#include <algorithm>
+
+using namespace std;
+
+const unsigned int DPLKYL002::LZ77::windowSize;
+const unsigned int DPLKYL002::LZ77::minMatch;
+const unsigned int DPLKYL002::LZ77::maxMatch;
+const unsigned int DPLKYL002::LZ77::endOfBlock;
+const unsigned int DPLKYL002::LZ77::numLengthSymbols;
+const unsigned int DPLKYL002::LZ77::numDistanceSymbols;
+
+const unsigned short DPLKYL002::LZ77::lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9,
+		10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131,
+		163, 195, 227, 258 };
+
+const unsigned char DPLKYL002::LZ77::lengthExtraBits[29] = { 0, 0, 0, 0, 0, 0,
+		0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+const unsigned short DPLKYL002::LZ77::distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9,
+		13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+		2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+
+const unsigned char DPLKYL002::LZ77::distanceExtraBits[30] = { 0, 0, 0, 0, 1, 1,
+		2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13,
+		13 };
+
+namespace {
+
+// match finder effort for each level (as in zlib)
+struct LevelSettings {
+	unsigned int lazyLength; // only look for a better match at the next letter below this length
+	unsigned int niceLength; // stop searching once a match this long is found
+	unsigned int chainLength; // hash chain entries searched per position
+};
+
+const LevelSettings levelSettings[10] = { { 0, 0, 0 }, { 0, 8, 4 },
+		{ 0, 16, 8 }, { 0, 32, 32 }, { 4, 16, 16 }, { 16, 32, 32 }, { 16, 128,
+				128 }, { 32, 128, 256 }, { 128, 258, 1024 }, { 258, 258, 4096 } };
+
+const unsigned int hashBits = 15;
+
+// 3 letter matches further back than this cost more than the literals
+const unsigned int tooFar = 4096;
+
+// the end of a hash chain (blocks are at most 0xFFFFFFFF bytes, so positions stop short of it)
+const unsigned int noPosition = 0xFFFFFFFF;
+
+inline unsigned int hashPrefix(const unsigned char * letter) {
+
+	unsigned int prefix = letter[0] | (letter[1] << 8) | (letter[2] << 16);
+
+	return (prefix * 2654435761u) >> (32 - hashBits);
+
+}
+
+}
+
+void DPLKYL002::LZ77::findMatches(const unsigned char * data, size_t size,
+		vector<Token> & tokens) {
+
+	tokens.clear();
+	tokens.reserve(size / 2);
+
+	const LevelSettings & settings = levelSettings[level];
+
+	vector<unsigned int> head(1u << hashBits, noPosition);
+	vector<unsigned int> previous(settings.chainLength > 0 ? size : 0);
+
+	// add position to its hash chain
+	auto insert = [&](size_t position) {
+
+		if (position + minMatch <= size) {
+
+			unsigned int hash = hashPrefix(data + position);
+			previous[position] = head[hash];
+			head[hash] = position;
+
+		}
+
+	};
+
+	// search the hash chain for the longest earlier match
+	auto longestMatch = [&](size_t position, unsigned int & distance) {
+
+		unsigned int bestLength = minMatch - 1;
+		unsigned int limit = min((size_t) maxMatch, size - position);
+
+		if (limit < minMatch) {
+
+			return 0u;
+
+		}
+
+		unsigned int candidate = head[hashPrefix(data + position)];
+
+		for (unsigned int chain = settings.chainLength;
+				candidate != noPosition && position - candidate <= windowSize
+						&& chain > 0;
+				chain--, candidate = previous[candidate]) {
+
+			const unsigned char * match = data + candidate;
+
+			if (match[bestLength] != data[position + bestLength]) {
+
+				continue;
+
+			}
+
+			unsigned int length = 0;
+
+			while (length < limit && match[length] == data[position + length]) {
+
+				length++;
+
+			}
+
+			if (length > bestLength) {
+
+				bestLength = length;
+				distance = position - candidate;
+
+				if (length >= settings.niceLength || length == limit) {
+
+					break;
+
+				}
+
+			}
+
+		}
+
+		if (bestLength < minMatch || (bestLength == minMatch && distance > tooFar)) {
+
+			return 0u;
+
+		}
+
+		return bestLength;
+
+	};
+
+	auto addLiteral = [&](unsigned char letter) {
+
+		Token token = { 0, 0, letter };
+		tokens.push_back(token);
+
+	};
+
+	if (settings.chainLength == 0) {
+
+		for (size_t i = 0; i < size; i++) {
+
+			addLiteral(data[i]);
+
+		}
+
+		return;
+
+	}
+
+	unsigned int length = 0, distance = 0;
+	bool haveMatch = false; // a match at position was already found by the lazy search
+
+	for (size_t position = 0; position < size;) {
+
+		if (!haveMatch) {
+
+			length = longestMatch(position, distance);
+
+		}
+
+		insert(position);
+		haveMatch = false;
+
+		// lazy matching: prefer a literal if the next position starts a longer match
+		if (length > 0 && length < settings.lazyLength) {
+
+			unsigned int nextDistance = 0;
+			unsigned int nextLength = longestMatch(position + 1, nextDistance);
+
+			if (nextLength > length) {
+
+				addLiteral(data[position]);
+				position++;
+
+				length = nextLength;
+				distance = nextDistance;
+				haveMatch = true;
+
+				continue;
+
+			}
+
+		}
+
+		if (length > 0) {
+
+			Token token = { (unsigned short) length, (unsigned short) distance, 0 };
+			tokens.push_back(token);
+
+			for (size_t i = position + 1; i < position + length; i++) {
+
+				insert(i);
+
+			}
+
+			position += length;
+
+		} else {
+
+			addLiteral(data[position]);
+			position++;
+
+		}
+
+	}
+
+}
+
+unsigned int DPLKYL002::LZ77::lengthSymbol(unsigned int length,
+		unsigned int & numExtraBits, unsigned int & extraBits) {
+
+	unsigned int code = upper_bound(lengthBase, lengthBase + 29, length)
+			- lengthBase - 1;
+
+	numExtraBits = lengthExtraBits[code];
+	extraBits = length - lengthBase[code];
+
+	return 257 + code;
+
+}
+
+unsigned int DPLKYL002::LZ77::distanceSymbol(unsigned int distance,
+		unsigned int & numExtraBits, unsigned int & extraBits) {
+
+	unsigned int code = upper_bound(distanceBase, distanceBase + 30, distance)
+			- distanceBase - 1;
+
+	numExtraBits = distanceExtraBits[code];
+	extraBits = distance - distanceBase[code];
+
+	return code;
+
+}
@@ -0,0 +1,73 @@
+//=======================================================================================
+// Name        : LZ77.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#ifndef LIBS_LZ77_H
+#define LIBS_LZ77_H
+
+#include <vector>
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*LZ77 front end: repeated phrases are replaced by (length, distance) references to an
+  earlier occurrence in a 32K window, found with hash chains over 3 letter prefixes.
+  Literals and lengths share one alphabet and distances have another, using the DEFLATE
+  symbol numbering, so each gets its own Huffman code.
+  */
+class LZ77 {
+
+private:
+	unsigned int level;
+
+public:
+
+	static const unsigned int windowSize = 32768;
+	static const unsigned int minMatch = 3;
+	static const unsigned int maxMatch = 258;
+
+	// literal / length alphabet: 256 literals, end of block, 29 length symbols
+	static const unsigned int endOfBlock = 256;
+	static const unsigned int numLengthSymbols = 286;
+	static const unsigned int numDistanceSymbols = 30;
+
+	// a literal when length is 0, otherwise a match
+	class Token {
+	public:
+		unsigned short length;
+		unsigned short distance;
+		unsigned char literal;
+	};
+
+	// level 0 stores literals only, levels 1 - 3 match greedily, levels 4 - 9 lazily
+	LZ77(unsigned int l) :
+			level(l > 9 ? 9 : l) {
+
+	}
+
+	// size is at most 0xFFFFFFFF (positions are kept in 32 bits)
+	void findMatches(const unsigned char * data, size_t size,
+			vector<Token> & tokens);
+
+	// DEFLATE symbol, extra bit count and extra bits for a match length / distance
+	static unsigned int lengthSymbol(unsigned int length,
+			unsigned int & numExtraBits, unsigned int & extraBits);
+	static unsigned int distanceSymbol(unsigned int distance,
+			unsigned int & numExtraBits, unsigned int & extraBits);
+
+	static const unsigned short lengthBase[29];
+	static const unsigned char lengthExtraBits[29];
+	static const unsigned short distanceBase[30];
+	static const unsigned char distanceExtraBits[30];
+
+};
+
+}
+
+#endif
@@ -0,0 +1,249 @@
+//=======================================================================================
+// Name        : RingBuffer.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#ifndef LIBS_RINGBUFFER_H
+#define LIBS_RINGBUFFER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// indices written by different threads are kept at least this far apart
+static const size_t cacheLineSize = 64;
+
+// smallest power of two holding at least capacity items
+inline size_t ringCapacity(size_t capacity) {
+
+	size_t size = 2;
+
+	while (size < capacity) {
+
+		size <<= 1;
+
+	}
+
+	return size;
+
+}
+
+/*A bounded lock-free queue for one producer thread and one consumer thread. The
+  producer only writes tail and the consumer only writes head, so each push or pop is a
+  load of the other index and a store of its own. Each side also keeps a copy of the
+  other's index and reads the shared one only when the copy says the ring is full (or
+  empty), so the cache lines move between the threads as little as possible.
+  */
+template<class T>
+class SpscRing {
+
+private:
+	vector<T> slots;
+	size_t mask;
+
+	char padding0[cacheLineSize];
+	atomic<size_t> head; // next slot to pop (written by the consumer)
+	size_t cachedTail; // the consumer's copy of tail
+	char padding1[cacheLineSize];
+	atomic<size_t> tail; // next slot to push (written by the producer)
+	size_t cachedHead; // the producer's copy of head
+	char padding2[cacheLineSize];
+
+public:
+
+	// the capacity is rounded up to a power of two
+	SpscRing(size_t capacity) :
+			slots(ringCapacity(capacity)), mask(slots.size() - 1), head(0), cachedTail(
+					0), tail(0), cachedHead(0) {
+
+	}
+
+	// returns false if the ring is full
+	bool tryPush(const T & item) {
+
+		size_t position = tail.load(memory_order_relaxed);
+
+		if (position - cachedHead == slots.size()) {
+
+			cachedHead = head.load(memory_order_acquire);
+
+			if (position - cachedHead == slots.size()) {
+
+				return false;
+
+			}
+
+		}
+
+		slots[position & mask] = item;
+		tail.store(position + 1, memory_order_release);
+
+		return true;
+
+	}
+
+	// returns false if the ring is empty
+	bool tryPop(T & item) {
+
+		size_t position = head.load(memory_order_relaxed);
+
+		if (position == cachedTail) {
+
+			cachedTail = tail.load(memory_order_acquire);
+
+			if (position == cachedTail) {
+
+				return false;
+
+			}
+
+		}
+
+		item = slots[position & mask];
+		head.store(position + 1, memory_order_release);
+
+		return true;
+
+	}
+
+	size_t capacity(void) const {
+
+		return slots.size();
+
+	}
+};
+
+/*A bounded lock-free queue for any number of producers and consumers (D. Vyukov's
+  design). Every slot carries a sequence number saying whose turn it is: a producer may
+  fill slot i of lap n when its sequence is n * capacity + i, and a consumer may empty it
+  when the sequence is one more than that. Producers and consumers each claim positions
+  with a compare-and-swap on their own index, then hand the slot over by storing its next
+  sequence number.
+  */
+template<class T>
+class MpmcRing {
+
+private:
+
+	class Slot {
+	public:
+
+		atomic<size_t> sequence;
+		T item;
+
+	};
+
+	unique_ptr<Slot[]> slots;
+	size_t mask;
+
+	char padding0[cacheLineSize];
+	atomic<size_t> head; // next position to pop
+	char padding1[cacheLineSize];
+	atomic<size_t> tail; // next position to push
+	char padding2[cacheLineSize];
+
+public:
+
+	// the capacity is rounded up to a power of two
+	MpmcRing(size_t capacity) :
+			slots(new Slot[ringCapacity(capacity)]), mask(ringCapacity(capacity) - 1), head(
+					0), tail(0) {
+
+		for (size_t i = 0; i <= mask; i++) {
+
+			slots[i].sequence.store(i, memory_order_relaxed);
+
+		}
+
+	}
+
+	// returns false if the ring is full
+	bool tryPush(const T & item) {
+
+		size_t position = tail.load(memory_order_relaxed);
+
+		while (true) {
+
+			Slot & slot = slots[position & mask];
+			size_t sequence = slot.sequence.load(memory_order_acquire);
+
+			if (sequence == position) {
+
+				if (tail.compare_exchange_weak(position, position + 1,
+						memory_order_relaxed)) {
+
+					slot.item = item;
+					slot.sequence.store(position + 1, memory_order_release);
+
+					return true;
+
+				}
+
+			} else if (sequence < position) {
+
+				return false; // the slot still holds an item from the last lap
+
+			} else {
+
+				position = tail.load(memory_order_relaxed);
+
+			}
+
+		}
+
+	}
+
+	// returns false if the ring is empty
+	bool tryPop(T & item) {
+
+		size_t position = head.load(memory_order_relaxed);
+
+		while (true) {
+
+			Slot & slot = slots[position & mask];
+			size_t sequence = slot.sequence.load(memory_order_acquire);
+
+			if (sequence == position + 1) {
+
+				if (head.compare_exchange_weak(position, position + 1,
+						memory_order_relaxed)) {
+
+					item = slot.item;
+					slot.sequence.store(position + mask + 1, memory_order_release);
+
+					return true;
+
+				}
+
+			} else if (sequence < position + 1) {
+
+				return false; // nothing has been pushed to this slot yet
+
+			} else {
+
+				position = head.load(memory_order_relaxed);
+
+			}
+
+		}
+
+	}
+
+	size_t capacity(void) const {
+
+		return mask + 1;
+
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,311 @@
+//=======================================================================================
+// Name        : ThreadPool.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#include "ThreadPool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// the pool and worker index of the current thread (nullptr for threads outside pools)
+thread_local const DPLKYL002::ThreadPool * currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+
+// a mutex for replacing the shared pool
+mutex sharedLock;
+
+}
+
+DPLKYL002::ThreadPool::ThreadPool(unsigned int numThreads, bool pinThreads) :
+		queued(0), nextWorker(0), stopping(false) {
+
+	numThreads = max(1u, numThreads);
+
+	for (unsigned int w = 0; w < numThreads; w++) {
+
+		workers.push_back(unique_ptr<Worker>(new Worker()));
+
+	}
+
+	// every deque exists before any worker starts stealing
+	for (unsigned int w = 0; w < numThreads; w++) {
+
+		workers[w]->worker = thread(&ThreadPool::workerLoop, this, w, pinThreads);
+
+	}
+
+}
+
+DPLKYL002::ThreadPool::~ThreadPool() {
+
+	{
+
+		lock_guard<mutex> guard(sleepLock);
+		stopping = true;
+
+	}
+
+	wakeUp.notify_all();
+
+	for (auto & worker : workers) {
+
+		worker->worker.join();
+
+	}
+
+}
+
+void DPLKYL002::ThreadPool::submit(TaskGroup & group, function<void()> task) {
+
+	size_t index = currentWorker();
+
+	// a worker keeps its own tasks, other threads deal them out in turn
+	if (index == workers.size()) {
+
+		index = nextWorker++ % workers.size();
+
+	}
+
+	group.pending++;
+
+	// counted first, so a thief can never take queued below zero
+	{
+
+		lock_guard<mutex> guard(sleepLock);
+		queued++;
+
+	}
+
+	{
+
+		lock_guard<mutex> guard(workers[index]->lock);
+		workers[index]->tasks.push_back(Task { move(task), &group });
+
+	}
+
+	// an idle worker, or a thread waiting for its own tasks, can take it
+	wakeUp.notify_one();
+	finished.notify_all();
+
+}
+
+void DPLKYL002::ThreadPool::wait(TaskGroup & group) {
+
+	size_t index = currentWorker();
+	Task task;
+
+	while (group.pending > 0) {
+
+		if (takeTask(index, task)) {
+
+			runTask(task);
+			continue;
+
+		}
+
+		unique_lock<mutex> guard(sleepLock);
+
+		finished.wait(guard, [&]() {
+
+			return group.pending == 0 || queued > 0;
+
+		});
+
+	}
+
+}
+
+void DPLKYL002::ThreadPool::forEach(size_t numTasks,
+		function<void(size_t)> work) {
+
+	TaskGroup group;
+
+	for (size_t t = 1; t < numTasks; t++) {
+
+		submit(group, [&work, t]() {
+
+			work(t);
+
+		});
+
+	}
+
+	if (numTasks > 0) {
+
+		work(0);
+
+	}
+
+	wait(group);
+
+}
+
+unsigned int DPLKYL002::ThreadPool::size(void) const {
+
+	return workers.size();
+
+}
+
+DPLKYL002::ThreadPool & DPLKYL002::ThreadPool::shared(void) {
+
+	lock_guard<mutex> guard(sharedLock);
+	unique_ptr<ThreadPool> & pool = sharedPool();
+
+	if (!pool) {
+
+		unsigned int cores = max(1u, thread::hardware_concurrency());
+		pool.reset(new ThreadPool(max(1u, cores - 1)));
+
+	}
+
+	return *pool;
+
+}
+
+void DPLKYL002::ThreadPool::configure(unsigned int numThreads,
+		bool pinThreads) {
+
+	lock_guard<mutex> guard(sharedLock);
+	unique_ptr<ThreadPool> & pool = sharedPool();
+
+	pool.reset(); // joins the old workers first
+	pool.reset(new ThreadPool(numThreads, pinThreads));
+
+}
+
+unique_ptr<DPLKYL002::ThreadPool> & DPLKYL002::ThreadPool::sharedPool(void) {
+
+	static unique_ptr<ThreadPool> pool;
+
+	return pool;
+
+}
+
+// the newest task of the worker's own deque, else the oldest task of another deque
+bool DPLKYL002::ThreadPool::takeTask(size_t index, Task & task) {
+
+	if (queued == 0) {
+
+		return false;
+
+	}
+
+	if (index < workers.size()) {
+
+		Worker & own = *workers[index];
+		lock_guard<mutex> guard(own.lock);
+
+		if (!own.tasks.empty()) {
+
+			task = move(own.tasks.back());
+			own.tasks.pop_back();
+			queued--;
+
+			return true;
+
+		}
+
+	}
+
+	for (size_t w = 1; w <= workers.size(); w++) {
+
+		Worker & victim = *workers[(index + w) % workers.size()];
+		lock_guard<mutex> guard(victim.lock);
+
+		if (!victim.tasks.empty()) {
+
+			task = move(victim.tasks.front());
+			victim.tasks.pop_front();
+			queued--;
+
+			return true;
+
+		}
+
+	}
+
+	return false;
+
+}
+
+void DPLKYL002::ThreadPool::runTask(Task & task) {
+
+	task.work();
+
+	TaskGroup * group = task.group;
+	task.work = nullptr;
+
+	// the waiting thread may destroy the group as soon as pending reaches 0
+	{
+
+		lock_guard<mutex> guard(sleepLock);
+		group->pending--;
+
+	}
+
+	finished.notify_all();
+
+}
+
+void DPLKYL002::ThreadPool::workerLoop(size_t index, bool pinThread) {
+
+	currentPool = this;
+	currentIndex = index;
+
+#ifdef __linux__
+	if (pinThread) {
+
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(index % max(1u, thread::hardware_concurrency()), &cpus);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+	}
+#endif
+
+	Task task;
+
+	while (true) {
+
+		if (takeTask(index, task)) {
+
+			runTask(task);
+			continue;
+
+		}
+
+		unique_lock<mutex> guard(sleepLock);
+
+		wakeUp.wait(guard, [this]() {
+
+			return queued > 0 || stopping;
+
+		});
+
+		if (stopping && queued == 0) {
+
+			return;
+
+		}
+
+	}
+
+}
+
+// this thread's worker index, or size() for threads outside the pool
+size_t DPLKYL002::ThreadPool::currentWorker(void) const {
+
+	return currentPool == this ? currentIndex : workers.size();
+
+}
@@ -0,0 +1,106 @@
+//=======================================================================================
+// Name        : ThreadPool.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 28/03/2019
+// Description : Huffman tree encoder - a compression algorithm used to compress English
+//               language text files, turning a sequence of ASCII characters into
+//				 a compressed bit stream - written in C++, Ansi-style
+//=======================================================================================
+
+#ifndef LIBS_THREADPOOL_H
+#define LIBS_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*The worker threads shared by every parallel part of the library. Each worker has its own
+  task deque: tasks a worker submits go on the back of its own deque and it takes them
+  from there (newest first), while idle workers steal from the front of the others'
+  deques (oldest, usually the largest pieces of work). Tasks from other threads are dealt
+  out to the deques in turn. A thread waiting for its tasks runs queued tasks meanwhile,
+  so tasks may submit and wait for tasks of their own. Tasks must not block on anything
+  but other tasks.
+  */
+class ThreadPool {
+
+public:
+
+	// tasks whose completion is waited for together
+	class TaskGroup {
+	public:
+
+		atomic<size_t> pending;
+
+		TaskGroup() :
+				pending(0) {
+
+		}
+	};
+
+	ThreadPool(unsigned int numThreads, bool pinThreads = false);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool & operator=(const ThreadPool &) = delete;
+
+	void submit(TaskGroup & group, function<void()> task);
+	void wait(TaskGroup & group);
+
+	// runs work(0) ... work(numTasks - 1) and returns when all are done
+	void forEach(size_t numTasks, function<void(size_t)> work);
+
+	unsigned int size(void) const;
+
+	// the pool owned by the library (one worker per core, less the calling thread)
+	static ThreadPool & shared(void);
+
+	// replaces the shared pool; call it only while the library is idle
+	static void configure(unsigned int numThreads, bool pinThreads = false);
+
+private:
+
+	class Task {
+	public:
+
+		function<void()> work;
+		TaskGroup * group;
+
+	};
+
+	class Worker {
+	public:
+
+		mutex lock;
+		deque<Task> tasks;
+		thread worker;
+
+	};
+
+	vector<unique_ptr<Worker>> workers;
+	atomic<size_t> queued; // tasks in all the deques
+	atomic<size_t> nextWorker; // where the next task from outside the pool goes
+	mutex sleepLock;
+	condition_variable wakeUp, finished;
+	bool stopping;
+
+	bool takeTask(size_t index, Task & task);
+	void runTask(Task & task);
+	void workerLoop(size_t index, bool pinThread);
+	size_t currentWorker(void) const;
+
+	static unique_ptr<ThreadPool> & sharedPool(void);
+};
+
+}
+
+#endif